@@ -47,3 +47,50 @@ struct scnhdr {
         long            s_flags;        /* flags */
       };
  
+
+/* The symbolic header, found at f_symptr, and the external symbols it
+ * points to -- just enough to map code addresses to procedure names.
+ */
+
+struct symhdr {
+        short   magic;          /* to verify validity of the table */
+        short   vstamp;         /* version stamp */
+        long    ilineMax;       /* number of line number entries */
+        long    cbLine;         /* number of bytes for line number entries */
+        long    cbLineOffset;   /* offset to start of line number entries */
+        long    idnMax;         /* max index into dense number table */
+        long    cbDnOffset;     /* offset to start dense number table */
+        long    ipdMax;         /* number of procedures */
+        long    cbPdOffset;     /* offset to procedure descriptor table */
+        long    isymMax;        /* number of local symbols */
+        long    cbSymOffset;    /* offset to start of local symbols */
+        long    ioptMax;        /* max index into optimization entries */
+        long    cbOptOffset;    /* offset to optimization entries */
+        long    iauxMax;        /* number of auxiliary symbols */
+        long    cbAuxOffset;    /* offset to start of auxiliary symbols */
+        long    issMax;         /* max index into local strings */
+        long    cbSsOffset;     /* offset to start of local strings */
+        long    issExtMax;      /* max index into external strings */
+        long    cbSsExtOffset;  /* offset to start of external strings */
+        long    ifdMax;         /* number of file descriptor entries */
+        long    cbFdOffset;     /* offset to file descriptor table */
+        long    crfd;           /* number of relative file descriptors */
+        long    cbRfdOffset;    /* offset to relative file descriptors */
+        long    iextMax;        /* number of external symbols */
+        long    cbExtOffset;    /* offset to start of external symbols */
+      };
+
+struct extsym {
+        short   flags;          /* jmptbl, cobol_main, weakext */
+        short   ifd;            /* where the symbol is defined */
+        long    iss;            /* index of the name in the string space */
+        long    value;          /* address, for a procedure */
+        unsigned long bits;     /* st:6, sc:5, reserved:1, index:20 */
+      };
+
+#define SymType(bits)           ((bits) & 0x3f)
+#define SymClass(bits)          (((bits) >> 6) & 0x1f)
+
+#define stProc          6       /* a procedure */
+#define stStaticProc    14      /* a static procedure */
+#define scText          1       /* in the text segment */
@@ -0,0 +1,402 @@
+/* tracesim.c
+ *
+ * This program replays an instruction trace recorded by "nachos -trace"
+ * (see ../machine/trace.h for the format) through models of the TLB,
+ * of page replacement in physical memory, and optionally of a cache,
+ * and prints their hit and miss counts.  It does not execute anything,
+ * so trying out another TLB size or replacement policy takes a pass
+ * over the trace instead of a run of the program.
+ *
+ * Usage: tracesim [-pagesize <bytes>] [-pages <#>] [-tlb <#>]
+ *		   [-tlbways <#>] [-asid] [-policy lru|fifo|clock|lfu]
+ *		   [-cache <bytes> <ways> <line bytes>] <trace file>
+ *
+ * The defaults are those of Nachos: 128 byte pages, 32 physical pages,
+ * and a fully associative 4 entry TLB, flushed on every context switch
+ * unless -asid is given.  Every instruction fetch, load and store goes
+ * through the TLB; a TLB miss looks the page up in memory, and a page
+ * fault brings it in, replacing a page chosen by the policy:
+ *	lru	-- the least recently used page
+ *	fifo	-- the page brought in first
+ *	clock	-- the first page not used since the clock hand last
+ *		   passed it
+ *	lfu	-- the page with the fewest TLB refills, counts being
+ *		   reset at each fault, as the Nachos PageManager does
+ * The cache is physically indexed, by the frame the page model put
+ * each page in, with LRU replacement.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TraceMagic	0x3152544e	/* must match ../machine/trace.h */
+#define TraceNone	0
+#define TraceLoad	1
+#define TraceStore	2
+#define TraceSwitch	3
+
+#define HashSize	4096		/* buckets for looking up pages */
+
+enum Policy { LRU, FIFO, CLOCK, LFU };
+
+/* A page of physical memory */
+typedef struct {
+    int valid;
+    int pid, vpn;		/* which page it holds */
+    unsigned long lastUsed;	/* for LRU */
+    unsigned long loaded;	/* for FIFO */
+    int referenced;		/* for CLOCK */
+    int refills;		/* for LFU */
+    int next;			/* next frame in the same hash bucket */
+} Frame;
+
+/* An entry of the TLB, or a line of the cache */
+typedef struct {
+    int valid;
+    int pid, tag;
+    int frame;			/* TLB only: the frame of the page */
+    unsigned long lastUsed;
+} Way;
+
+static int pageSize = 128, numFrames = 32;
+static int tlbSize = 4, tlbWays = 0, tagTLB = 0;
+static enum Policy policy = LRU;
+static int cacheSize = 0, cacheWays = 0, lineSize = 0;
+
+static Frame *frames;
+static int buckets[HashSize];
+static int clockHand = 0;
+static Way *tlb, *cache;
+static int tlbSets, cacheSets;
+static unsigned long now = 0;	/* counts accesses */
+
+static unsigned long instructions = 0, loads = 0, stores = 0, switches = 0;
+static unsigned long tlbMisses = 0, pageFaults = 0;
+static unsigned long cacheHits = 0, cacheMisses = 0;
+
+static FILE *trace;
+
+static void
+Usage()
+{
+    fprintf(stderr, "Usage: tracesim [-pagesize <bytes>] [-pages <#>] "
+		"[-tlb <#>] [-tlbways <#>] [-asid]\n"
+		"\t[-policy lru|fifo|clock|lfu] "
+		"[-cache <bytes> <ways> <line bytes>] <trace file>\n");
+    exit(1);
+}
+
+/* Read a number stored by TraceRecorder::PutNumber.  Returns 0 at the
+ * end of the trace.
+ */
+static int
+GetNumber(int *n)
+{
+    unsigned int zigzag = 0;
+    int shift = 0, c;
+
+    do {
+	if ((c = getc(trace)) == EOF)
+	    return 0;
+	zigzag |= (unsigned int) (c & 0x7f) << shift;
+	shift += 7;
+    } while (c & 0x80);
+    *n = (int) (zigzag >> 1) ^ -(int) (zigzag & 1);
+    return 1;
+}
+
+static int
+Hash(int pid, int vpn)
+{
+    return ((unsigned) (vpn + pid * 314)) % HashSize;
+}
+
+/* The frame holding page "vpn" of process "pid", or -1 */
+static int
+FindFrame(int pid, int vpn)
+{
+    int f;
+
+    for (f = buckets[Hash(pid, vpn)]; f != -1; f = frames[f].next)
+	if ((frames[f].pid == pid) && (frames[f].vpn == vpn))
+	    return f;
+    return -1;
+}
+
+/* Choose the frame to replace, and take its page out of memory and
+ * out of the TLB.
+ */
+static int
+Evict()
+{
+    int victim = 0, f, line, *link;
+
+    for (f = 0; f < numFrames; f++)
+	if (!frames[f].valid)
+	    return f;
+    switch (policy) {
+      case LRU:
+	for (f = 1; f < numFrames; f++)
+	    if (frames[f].lastUsed < frames[victim].lastUsed)
+		victim = f;
+	break;
+      case FIFO:
+	for (f = 1; f < numFrames; f++)
+	    if (frames[f].loaded < frames[victim].loaded)
+		victim = f;
+	break;
+      case CLOCK:
+	while (frames[clockHand].referenced) {
+	    frames[clockHand].referenced = 0;
+	    clockHand = (clockHand + 1) % numFrames;
+	}
+	victim = clockHand;
+	clockHand = (clockHand + 1) % numFrames;
+	break;
+      case LFU:
+	for (f = 1; f < numFrames; f++)
+	    if (frames[f].refills < frames[victim].refills)
+		victim = f;
+	for (f = 0; f < numFrames; f++)
+	    frames[f].refills = 0;
+	break;
+    }
+
+    for (link = &buckets[Hash(frames[victim].pid, frames[victim].vpn)];
+		*link != victim; link = &frames[*link].next)
+	;
+    *link = frames[victim].next;
+    frames[victim].valid = 0;
+    for (f = 0; f < tlbSize; f++)
+	if (tlb[f].frame == victim)
+	    tlb[f].valid = 0;
+    if (cache != NULL)		/* its lines are about to be overwritten */
+	for (line = victim * pageSize / lineSize;
+		line < (victim + 1) * pageSize / lineSize; line++)
+	    for (f = 0; f < cacheWays; f++)
+		if (cache[(line % cacheSets) * cacheWays + f].tag == line)
+		    cache[(line % cacheSets) * cacheWays + f].valid = 0;
+    return victim;
+}
+
+/* Look up a page that missed in the TLB, bringing it into memory if
+ * it is not there.
+ */
+static int
+PageIn(int pid, int vpn)
+{
+    int f = FindFrame(pid, vpn);
+
+    if (f == -1) {
+	pageFaults++;
+	f = Evict();
+	frames[f].valid = 1;
+	frames[f].pid = pid;
+	frames[f].vpn = vpn;
+	frames[f].loaded = now;
+	frames[f].refills = 0;
+	frames[f].next = buckets[Hash(pid, vpn)];
+	buckets[Hash(pid, vpn)] = f;
+    }
+    frames[f].refills++;
+    return f;
+}
+
+/* Find "tag" of process "pid" in the set of "ways" entries at "set",
+ * and make it the most recently used.  On a miss, replace the least
+ * recently used entry, and return it with valid == 0 for the caller
+ * to fill in.
+ */
+static Way *
+LookUp(Way *set, int ways, int pid, int tag)
+{
+    Way *victim = set;
+    int i;
+
+    for (i = 0; i < ways; i++) {
+	if (set[i].valid && (set[i].pid == pid) && (set[i].tag == tag)) {
+	    set[i].lastUsed = now;
+	    return &set[i];
+	}
+	if (!set[i].valid)
+	    victim = &set[i];
+	else if (victim->valid && (set[i].lastUsed < victim->lastUsed))
+	    victim = &set[i];
+    }
+    victim->valid = 0;
+    victim->pid = pid;
+    victim->tag = tag;
+    victim->lastUsed = now;
+    return victim;
+}
+
+/* One instruction fetch, load or store of virtual address "addr" */
+static void
+Access(int pid, int addr)
+{
+    int vpn = (unsigned) addr / pageSize;
+    int set = ((unsigned) (vpn + (tagTLB ? pid : 0) * 314) % tlbSets)
+		* tlbWays;
+    Way *entry;
+    int physAddr, line;
+
+    now++;
+    entry = LookUp(&tlb[set], tlbWays, tagTLB ? pid : 0, vpn);
+    if (!entry->valid) {
+	tlbMisses++;
+	entry->frame = PageIn(pid, vpn);
+	entry->valid = 1;
+    }
+    frames[entry->frame].lastUsed = now;
+    frames[entry->frame].referenced = 1;
+
+    if (cache == NULL)
+	return;
+    physAddr = entry->frame * pageSize + (unsigned) addr % pageSize;
+    line = physAddr / lineSize;
+    entry = LookUp(&cache[(line % cacheSets) * cacheWays], cacheWays, 0, line);
+    if (entry->valid)
+	cacheHits++;
+    else {
+	cacheMisses++;
+	entry->valid = 1;
+    }
+}
+
+static void
+FlushTLB()
+{
+    int i;
+
+    for (i = 0; i < tlbSize; i++)
+	tlb[i].valid = 0;
+}
+
+static void
+Percent(char *what, unsigned long count, unsigned long of)
+{
+    printf("%-16s %12lu  %6.2f%%\n", what, count,
+		of == 0 ? 0.0 : 100.0 * count / of);
+}
+
+int
+main(int argc, char **argv)
+{
+    int magic, tag, delta, pid = 0, i;
+    int pc = -4, memAddr = 0;
+    char *policyName = "lru";
+
+    for (argc--, argv++; argc > 1; argc--, argv++) {
+	if (!strcmp(*argv, "-pagesize") && (argc > 2)) {
+	    pageSize = atoi(*++argv);
+	    argc--;
+	} else if (!strcmp(*argv, "-pages") && (argc > 2)) {
+	    numFrames = atoi(*++argv);
+	    argc--;
+	} else if (!strcmp(*argv, "-tlb") && (argc > 2)) {
+	    tlbSize = atoi(*++argv);
+	    argc--;
+	} else if (!strcmp(*argv, "-tlbways") && (argc > 2)) {
+	    tlbWays = atoi(*++argv);
+	    argc--;
+	} else if (!strcmp(*argv, "-asid"))
+	    tagTLB = 1;
+	else if (!strcmp(*argv, "-policy") && (argc > 2)) {
+	    policyName = *++argv;
+	    argc--;
+	    if (!strcmp(policyName, "lru"))
+		policy = LRU;
+	    else if (!strcmp(policyName, "fifo"))
+		policy = FIFO;
+	    else if (!strcmp(policyName, "clock"))
+		policy = CLOCK;
+	    else if (!strcmp(policyName, "lfu"))
+		policy = LFU;
+	    else
+		Usage();
+	} else if (!strcmp(*argv, "-cache") && (argc > 4)) {
+	    cacheSize = atoi(argv[1]);
+	    cacheWays = atoi(argv[2]);
+	    lineSize = atoi(argv[3]);
+	    argv += 3;
+	    argc -= 3;
+	} else
+	    Usage();
+    }
+    if (argc != 1)
+	Usage();
+    if (tlbWays == 0)
+	tlbWays = tlbSize;
+    if ((pageSize <= 0) || (numFrames <= 0) || (tlbWays <= 0)
+		|| (tlbSize % tlbWays != 0)) {
+	fprintf(stderr, "tracesim: bad memory or TLB geometry\n");
+	exit(1);
+    }
+    if ((cacheSize > 0) && ((cacheWays <= 0) || (lineSize <= 0)
+		|| (cacheSize % (cacheWays * lineSize) != 0))) {
+	fprintf(stderr, "tracesim: bad cache geometry\n");
+	exit(1);
+    }
+
+    if ((trace = fopen(*argv, "rb")) == NULL) {
+	perror(*argv);
+	exit(1);
+    }
+    if ((fread(&magic, sizeof(magic), 1, trace) != 1)
+		|| (magic != TraceMagic)) {
+	fprintf(stderr, "tracesim: %s is not a Nachos trace\n", *argv);
+	exit(1);
+    }
+
+    frames = (Frame *) calloc(numFrames, sizeof(Frame));
+    for (i = 0; i < HashSize; i++)
+	buckets[i] = -1;
+    tlbSets = tlbSize / tlbWays;
+    tlb = (Way *) calloc(tlbSize, sizeof(Way));
+    if (cacheSize > 0) {
+	cacheSets = cacheSize / (cacheWays * lineSize);
+	cache = (Way *) calloc(cacheSets * cacheWays, sizeof(Way));
+    }
+
+    while ((tag = getc(trace)) != EOF) {
+	if ((tag & 3) == TraceSwitch) {
+	    if (!GetNumber(&pid))
+		break;
+	    switches++;
+	    if (!tagTLB)
+		FlushTLB();
+	    continue;
+	}
+	if (!GetNumber(&delta))
+	    break;
+	pc += 4 + delta;
+	instructions++;
+	Access(pid, pc);
+	if ((tag & 3) != TraceNone) {
+	    if (!GetNumber(&delta))
+		break;
+	    memAddr += delta;
+	    if ((tag & 3) == TraceLoad)
+		loads++;
+	    else
+		stores++;
+	    Access(pid, memAddr);
+	}
+    }
+    fclose(trace);
+
+    printf("%lu instructions, %lu loads, %lu stores, %lu context switches\n",
+		instructions, loads, stores, switches);
+    printf("TLB: %d entries, %d-way%s; memory: %d pages of %d bytes, %s\n",
+		tlbSize, tlbWays, tagTLB ? ", tagged" : "", numFrames,
+		pageSize, policyName);
+    Percent("TLB misses", tlbMisses, now);
+    Percent("page faults", pageFaults, now);
+    if (cache != NULL) {
+	printf("cache: %d bytes, %d-way, %d byte lines\n", cacheSize,
+		cacheWays, lineSize);
+	Percent("cache misses", cacheMisses, cacheHits + cacheMisses);
+    }
+    return 0;
+}
@@ -25,6 +25,16 @@
 #include "copyright.h"
 #include "filehdr.h"
 #include "indfilehdr.h"
+#include "slab.h"
+
+// ByteToSector, and every other walk of a large file, reads its
+// indirect blocks into a scratch IndFileHeader
+static SlabCache indirectCache("indirect block", sizeof(IndFileHeader));
+
+void *IndFileHeader::operator new(size_t size)
+{ return indirectCache.Alloc(size); }
+void IndFileHeader::operator delete(void *p)
+{ indirectCache.Free(p); }
 
 //----------------------------------------------------------------------
 // FileHeader::Allocate
@@ -9,6 +9,8 @@
 
 class IndFileHeader {
   public:
+    void *operator new(size_t size);	// allocated from a slab cache,
+    void operator delete(void *p);	// see slab.h (and filehdr.cc)
 
     void FetchFrom(int sector) {
          synchDisk->ReadSector(sector, (char *)this);
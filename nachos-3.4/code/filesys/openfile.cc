@@ -15,10 +15,35 @@
 #include "filehdr.h"
 #include "openfile.h"
 #include "system.h"
+#include "slab.h"
 #ifdef HOST_SPARC
 #include <strings.h>
 #endif
 
+// Sector buffers for ReadAt and WriteAt.  Requests of up to
+// SlabBufferSectors sectors -- nearly all of them -- take a buffer
+// from the cache; larger ones get one from the host.
+#define SlabBufferSectors	4
+
+static SlabCache bufferCache("sector buffer", SlabBufferSectors * SectorSize);
+
+static char *
+AllocSectors(int numSectors)
+{
+    if (numSectors <= SlabBufferSectors)
+	return (char *) bufferCache.Alloc(numSectors * SectorSize);
+    return new char[numSectors * SectorSize];
+}
+
+static void
+FreeSectors(char *buf, int numSectors)
+{
+    if (numSectors <= SlabBufferSectors)
+	bufferCache.Free(buf);
+    else
+	delete [] buf;
+}
+
 //----------------------------------------------------------------------
 // OpenFile::OpenFile
 // 	Open a Nachos file for reading and writing.  Bring the file header
@@ -138,7 +163,7 @@ OpenFile::ReadAt(char *into, int numBytes, int position)
     numSectors = 1 + lastSector - firstSector;
 
     // read in all the full and partial sectors that we need
-    buf = new char[numSectors * SectorSize];
+    buf = AllocSectors(numSectors);
     fileManager->ReadStart(fd);
     for (i = firstSector; i <= lastSector; i++)	
         synchDisk->ReadSectorFast(hdr->ByteToSector(i * SectorSize), 
@@ -147,7 +172,7 @@ OpenFile::ReadAt(char *into, int numBytes, int position)
     hdr->UpdateLastAccessTime();
     // copy the part we want
     bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
-    delete [] buf;   
+    FreeSectors(buf, numSectors);
     return numBytes;
 }
 
@@ -180,7 +205,7 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
     numSectors = 1 + lastSector - firstSector;
 
 
-    buf = new char[numSectors * SectorSize];
+    buf = AllocSectors(numSectors);
 
     firstAligned = (position == (firstSector * SectorSize));
     lastAligned = ((position + numBytes) == ((lastSector + 1) * SectorSize));
@@ -210,7 +235,7 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
     }
     fileManager->WriteEnd(fd);
     hdr->UpdateLastModifyTime();
-    delete [] buf;
+    FreeSectors(buf, numSectors);
     return numBytes;
 }
 
@@ -16,6 +16,7 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "system.h"
 
 //----------------------------------------------------------------------
 // DiskRequestDone
@@ -76,6 +77,7 @@ SynchDisk::ReadSector(int sectorNumber, char* data)
 {
     lock->Acquire();			// only one disk I/O at a time
     disk->ReadRequest(sectorNumber, data);
+    scheduler->IOWait(currentThread);
     semaphore->P();			// wait for interrupt
     lock->Release();
 }
@@ -101,6 +103,7 @@ SynchDisk::WriteSector(int sectorNumber, char* data)
 {
     lock->Acquire();			// only one disk I/O at a time
     disk->WriteRequest(sectorNumber, data);
+    scheduler->IOWait(currentThread);
     semaphore->P();			// wait for interrupt
     lock->Release();
 }
@@ -0,0 +1,107 @@
+// cache.cc 
+//	Routines to simulate the timing of the processor caches.
+//	See cache.h.
+
+#include "copyright.h"
+#include "cache.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// Cache::Cache
+// 	Initialize an empty cache.
+//
+//	"debugName" -- name for the statistics
+//	"size" -- total size in bytes
+//	"ways" -- associativity: number of lines in each set
+//	"lineBytes" -- bytes per line
+//	"nextLevel" -- where misses are served from; NULL for memory
+//----------------------------------------------------------------------
+
+Cache::Cache(char *debugName, int size, int ways, int lineBytes,
+		Cache *nextLevel)
+{
+    ASSERT((ways > 0) && (lineBytes >= 4) && (size % (ways * lineBytes) == 0));
+    name = debugName;
+    numWays = ways;
+    lineSize = lineBytes;
+    numSets = size / (ways * lineBytes);
+    ASSERT(numSets > 0);
+    next = nextLevel;
+
+    tags = new int[numSets * numWays];
+    lastUsed = new int[numSets * numWays];
+    for (int i = 0; i < numSets * numWays; i++) {
+	tags[i] = -1;
+	lastUsed[i] = 0;
+    }
+    useClock = 0;
+    hits = misses = stallTicks = 0;
+}
+
+//----------------------------------------------------------------------
+// Cache::~Cache
+// 	De-allocate the tags.  The next level belongs to the caller.
+//----------------------------------------------------------------------
+
+Cache::~Cache()
+{
+    delete [] tags;
+    delete [] lastUsed;
+}
+
+//----------------------------------------------------------------------
+// Cache::Access
+// 	Simulate one access to physical address "physAddr".  On a miss,
+//	the least recently used line of the set is replaced, and the line 
+//	is fetched from the next level.
+//
+//	Returns the number of ticks the access stalls the CPU: 0 on a 
+//	hit, otherwise the time for the next level to supply the line.
+//----------------------------------------------------------------------
+
+int
+Cache::Access(int physAddr)
+{
+    int line = physAddr / lineSize;
+    int first = (line % numSets) * numWays;
+    int victim = first;
+    int stall;
+
+    useClock++;
+    for (int i = first; i < first + numWays; i++) {
+	if (tags[i] == line) {
+	    hits++;
+	    lastUsed[i] = useClock;
+	    return 0;
+	}
+	if (lastUsed[i] < lastUsed[victim])
+	    victim = i;
+    }
+
+    misses++;
+    tags[victim] = line;
+    lastUsed[victim] = useClock;
+    if (next == NULL)
+	stall = MemoryTime;
+    else
+	stall = CacheL2Time + next->Access(physAddr);
+    stallTicks += stall;
+    return stall;
+}
+
+//----------------------------------------------------------------------
+// Cache::Print
+// 	Print the hit and miss counts, and the time lost to misses.
+//----------------------------------------------------------------------
+
+void
+Cache::Print()
+{
+    int accesses = hits + misses;
+
+    printf("%s cache (%d sets, %d ways, %d byte lines): %d hits, %d misses",
+	   name, numSets, numWays, lineSize, hits, misses);
+    if (accesses > 0)
+	printf(" (%.2f%% miss rate)", 100.0 * misses / accesses);
+    printf(", %d stall ticks\n", stallTicks);
+}
@@ -0,0 +1,51 @@
+// cache.h 
+//	Data structures for a timing model of the processor caches.
+//
+//	Only the tags are simulated -- the data always comes from 
+//	mainMemory -- so the caches change how long user programs take,
+//	never what they compute.  Caches are physically indexed, use LRU
+//	replacement, and allocate a line on every miss, reads and writes
+//	alike.  A miss stalls the CPU for CacheL2Time ticks if the line is
+//	found in the L2 cache.  A miss that has to go to memory costs
+//	MemoryTime ticks, plus CacheL2Time for the L2 lookup on the way if
+//	there is an L2 cache (see stats.h).
+//
+//	The caches are configured with -l1 and -l2; without -l1 there
+//	are none, and every instruction takes exactly UserTick.
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Cache {
+  public:
+    Cache(char *debugName, int size, int ways, int lineSize, Cache *nextLevel);
+				// a "size" byte cache of "ways"-way sets of
+				// "lineSize" byte lines, backed by 
+				// "nextLevel" (NULL: main memory)
+    ~Cache();
+
+    int Access(int physAddr);	// look up the line holding "physAddr",
+				// loading it if necessary; return the
+				// number of ticks the access stalls
+
+    void Print();		// print hit and miss counts
+
+  private:
+    char *name;			// for printing
+    int numSets;
+    int numWays;
+    int lineSize;
+    Cache *next;		// cache below this one, or NULL
+
+    int *tags;			// line number held by each way, or -1
+    int *lastUsed;		// when each way was last used, for LRU
+    int useClock;		// counts accesses, to order lastUsed
+
+    int hits, misses;
+    int stallTicks;		// ticks lost to misses in this cache
+};
+
+#endif // CACHE_H
@@ -55,8 +55,9 @@ Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail,
     putBusy = FALSE;
     incoming = EOF;
 
-    // start polling for incoming packets
-    interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, ConsoleReadInt);
+    // interrupt when a character is typed
+    interrupt->WatchIO(readFileNo, ConsoleReadPoll, (int)this, ConsoleTime,
+			ConsoleReadInt);
 }
 
 //----------------------------------------------------------------------
@@ -66,6 +67,7 @@ Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail,
 
 Console::~Console()
 {
+    interrupt->IgnoreIO(readFileNo);
     if (readFileNo != 0)
 	Close(readFileNo);
     if (writeFileNo != 1)
@@ -74,11 +76,11 @@ Console::~Console()
 
 //----------------------------------------------------------------------
 // Console::CheckCharAvail()
-// 	Periodically called to check if a character is available for
-//	input from the simulated keyboard (eg, has it been typed?).
+// 	Called when a character has been typed on the simulated keyboard.
 //
-//	Only read it in if there is buffer space for it (if the previous
-//	character has been grabbed out of the buffer by the Nachos kernel).
+//	The keyboard is only watched while there is buffer space for
+//	the character (while the previous character has been grabbed
+//	out of the buffer by the Nachos kernel; see GetChar).
 //	Invoke the "read" interrupt handler, once the character has been 
 //	put into the buffer. 
 //----------------------------------------------------------------------
@@ -88,12 +90,8 @@ Console::CheckCharAvail()
 {
     char c;
 
-    // schedule the next time to poll for a packet
-    interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, 
-			ConsoleReadInt);
-
-    // do nothing if character is already buffered, or none to be read
-    if ((incoming != EOF) || !PollFile(readFileNo))
+    // do nothing if character is already buffered
+    if (incoming != EOF)
 	return;	  
 
     // otherwise, read character and tell user about it
@@ -130,6 +128,7 @@ Console::GetChar()
    char ch = incoming;
 
    incoming = EOF;
+   interrupt->ArmIO(readFileNo);	// room for the next character
    return ch;
 }
 
@@ -0,0 +1,150 @@
+// costmodel.cc 
+//	Routines to charge user instructions by class.  See costmodel.h.
+
+#include "copyright.h"
+#include "costmodel.h"
+#include "machine.h"
+#include "mipssim.h"
+#include "system.h"
+
+static char *costNames[NumCostClasses] = { "alu", "shift", "mult", "div",
+	"load", "store", "branch", "jump", "syscall" };
+
+//----------------------------------------------------------------------
+// CostModel::CostModel
+// 	Classify every opcode, and read the cost of each class from the
+//	cost file.  A bad line in the file is fatal: a run with the wrong 
+//	costs would just give wrong times.
+//
+//	"fileName" -- the UNIX file with the costs, see costmodel.h
+//----------------------------------------------------------------------
+
+CostModel::CostModel(char *fileName)
+{
+    char line[100], name[100];
+    int value, lineNum = 0, i;
+    FILE *fp;
+
+    for (i = 0; i < NumCostClasses; i++) {
+	cost[i] = UserTick;
+	executed[i] = ticks[i] = 0;
+    }
+    loadUse = taken = 0;
+    lastLoad = 0;
+    loadUseStalls = takenBranches = 0;
+
+    for (i = 0; i <= MaxOpcode; i++)
+	opClass[i] = AluCost;
+    opClass[OP_SLL] = opClass[OP_SLLV] = opClass[OP_SRA] = ShiftCost;
+    opClass[OP_SRAV] = opClass[OP_SRL] = opClass[OP_SRLV] = ShiftCost;
+    opClass[OP_MULT] = opClass[OP_MULTU] = MultCost;
+    opClass[OP_DIV] = opClass[OP_DIVU] = DivCost;
+    opClass[OP_LB] = opClass[OP_LBU] = opClass[OP_LH] = LoadCost;
+    opClass[OP_LHU] = opClass[OP_LW] = opClass[OP_LWL] = LoadCost;
+    opClass[OP_LWR] = LoadCost;
+    opClass[OP_SB] = opClass[OP_SH] = opClass[OP_SW] = StoreCost;
+    opClass[OP_SWL] = opClass[OP_SWR] = StoreCost;
+    opClass[OP_BEQ] = opClass[OP_BNE] = opClass[OP_BGEZ] = BranchCost;
+    opClass[OP_BGEZAL] = opClass[OP_BGTZ] = opClass[OP_BLEZ] = BranchCost;
+    opClass[OP_BLTZ] = opClass[OP_BLTZAL] = BranchCost;
+    opClass[OP_J] = opClass[OP_JAL] = opClass[OP_JALR] = JumpCost;
+    opClass[OP_JR] = JumpCost;
+    opClass[OP_SYSCALL] = SyscallCost;
+
+    if ((fp = fopen(fileName, "r")) == NULL) {
+	printf("CostModel: unable to open %s\n", fileName);
+	Abort();
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+	lineNum++;
+	for (i = 0; (line[i] != '\0') && (line[i] != '#'); i++)
+	    ;
+	line[i] = '\0';				// strip the comment
+	if (sscanf(line, "%99s", name) != 1)
+	    continue;				// blank line
+	if ((sscanf(line, "%99s %d", name, &value) != 2) || (value < 0)) {
+	    printf("CostModel: %s, line %d: expected <name> <ticks>\n", 
+		    fileName, lineNum);
+	    Abort();
+	}
+	if (!strcmp(name, "loaduse"))
+	    loadUse = value;
+	else if (!strcmp(name, "taken"))
+	    taken = value;
+	else {
+	    for (i = 0; i < NumCostClasses; i++)
+		if (!strcmp(name, costNames[i]))
+		    break;
+	    if (i == NumCostClasses) {
+		printf("CostModel: %s, line %d: unknown class %s\n", 
+			fileName, lineNum, name);
+		Abort();
+	    }
+	    cost[i] = value;
+	}
+    }
+    fclose(fp);
+}
+
+//----------------------------------------------------------------------
+// CostModel::Charge
+// 	Return how many ticks, beyond the UserTick every instruction is
+//	charged, the instruction at "pc" takes: the cost of its class 
+//	minus UserTick, plus the load-use and taken-branch penalties.
+//
+//	The registers an instruction reads are rs, and rt too for the 
+//	SPECIAL (register-register) instructions, stores, beq and bne.
+//	Every instruction takes at least UserTick.
+//----------------------------------------------------------------------
+
+int
+CostModel::Charge(Instruction *instr, int pc, int nextPC)
+{
+    int which = opClass[(int) instr->opCode];
+    int major = (instr->value >> 26) & 0x3f;	// opcode field
+    int extra = cost[which] - UserTick;
+
+    if (extra < 0)
+	extra = 0;
+    if ((lastLoad != 0) && ((instr->rs == lastLoad) || 
+		(((major == 0) || (major == 4) || (major == 5) || 
+		  (which == StoreCost)) && (instr->rt == lastLoad)))) {
+	extra += loadUse;
+	loadUseStalls++;
+    }
+    lastLoad = (which == LoadCost) ? instr->rt : 0;
+    if (((which == BranchCost) || (which == JumpCost)) && 
+		(nextPC != pc + 8)) {
+	extra += taken;
+	takenBranches++;
+    }
+
+    executed[which]++;
+    ticks[which] += UserTick + extra;
+    return extra;
+}
+
+//----------------------------------------------------------------------
+// CostModel::Print
+// 	Print the instructions and ticks of each class, and how often
+//	each penalty was paid.
+//----------------------------------------------------------------------
+
+void
+CostModel::Print()
+{
+    int total = 0, i;
+
+    for (i = 0; i < NumCostClasses; i++)
+	total += ticks[i];
+    if (total == 0)
+	total = 1;			// avoid dividing by zero below
+    printf("\nInstruction costs:\n%-8s %5s %12s %12s %6s\n", "class", 
+		"cost", "executed", "ticks", "%");
+    for (i = 0; i < NumCostClasses; i++)
+	printf("%-8s %5d %12d %12d %5.1f%%\n", costNames[i], cost[i], 
+		executed[i], ticks[i], 100.0 * ticks[i] / total);
+    printf("load-use stalls %d (%d ticks each), taken branches %d "
+		"(%d ticks each)\n", loadUseStalls, loadUse, takenBranches, 
+		taken);
+}
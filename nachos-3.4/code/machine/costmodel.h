@@ -0,0 +1,64 @@
+// costmodel.h 
+//	Data structures for charging user instructions by what they do,
+//	instead of UserTick for every one.
+//
+//	Instructions are grouped into classes -- ALU, shift, multiply,
+//	divide, load, store, branch, jump and syscall -- each costing a 
+//	number of ticks given in a cost file, UserTick if not given.  Two
+//	pipeline penalties can be added: "loaduse" ticks when an 
+//	instruction reads the register the instruction before it loaded,
+//	and "taken" ticks when a branch or jump changes the flow of 
+//	control.
+//
+//	The cost file has one "<class> <ticks>" or "<penalty> <ticks>"
+//	per line, with the names above in lower case; '#' starts a 
+//	comment.  For example:
+//
+//		mult	12
+//		div	35
+//		load	2
+//		loaduse	1
+//		taken	1
+//
+//	The cost model is set up with -cost, and like the profiler it 
+//	makes user programs run on the interpreter.
+
+#ifndef COSTMODEL_H
+#define COSTMODEL_H
+
+#include "copyright.h"
+#include "utility.h"
+
+enum CostClass { AluCost, ShiftCost, MultCost, DivCost, LoadCost, 
+		 StoreCost, BranchCost, JumpCost, SyscallCost, 
+		 NumCostClasses };
+
+class Instruction;
+
+class CostModel {
+  public:
+    CostModel(char *fileName);	// read the costs from a UNIX file
+
+    int Charge(Instruction *instr, int pc, int nextPC);
+				// the ticks beyond UserTick that the
+				// instruction at "pc", just executed, 
+				// takes; "nextPC" is where it goes after
+				// its delay slot
+    void Flush() { lastLoad = 0; }	// the pipeline drains, on an
+				// exception or interrupt
+    void Print();		// print where the time went
+
+  private:
+    int cost[NumCostClasses];	// ticks for each class
+    int loadUse;		// penalty ticks for using a load result at once
+    int taken;			// penalty ticks for a taken branch or jump
+    char opClass[64];		// CostClass of each opCode (mipssim.h)
+    int lastLoad;		// register the previous instruction loaded,
+				// or 0
+
+    int executed[NumCostClasses];	// instructions of each class
+    int ticks[NumCostClasses];		// and the ticks they took
+    int loadUseStalls, takenBranches;
+};
+
+#endif // COSTMODEL_H
@@ -0,0 +1,173 @@
+// eventqueue.cc 
+//	Routines to manage a priority queue of events.  See eventqueue.h.
+
+#include "copyright.h"
+#include "eventqueue.h"
+
+//----------------------------------------------------------------------
+// EventQueue::EventQueue
+// 	Initialize an empty queue, with room for a few events.
+//----------------------------------------------------------------------
+
+EventQueue::EventQueue()
+{
+    maxEntries = 16;
+    heap = new EventQueueEntry[maxEntries];
+    numEntries = 0;
+    numInserted = 0;
+}
+
+//----------------------------------------------------------------------
+// EventQueue::~EventQueue
+// 	De-allocate the queue.  As with a List, the items themselves are
+//	the caller's to de-allocate.
+//----------------------------------------------------------------------
+
+EventQueue::~EventQueue()
+{
+    delete [] heap;
+}
+
+bool
+EventQueue::Before(int a, int b)
+{
+    if (heap[a].key != heap[b].key)
+	return (heap[a].key < heap[b].key);
+    return ((int) (heap[a].order - heap[b].order) < 0);	// wraps safely
+}
+
+void
+EventQueue::Swap(int a, int b)
+{
+    EventQueueEntry tmp = heap[a];
+
+    heap[a] = heap[b];
+    heap[b] = tmp;
+}
+
+void
+EventQueue::SiftUp(int i)
+{
+    while ((i > 0) && Before(i, (i - 1) / 2)) {
+	Swap(i, (i - 1) / 2);
+	i = (i - 1) / 2;
+    }
+}
+
+void
+EventQueue::SiftDown(int i)
+{
+    for (;;) {
+	int child = 2 * i + 1;
+
+	if (child >= numEntries)
+	    return;
+	if ((child + 1 < numEntries) && Before(child + 1, child))
+	    child++;
+	if (!Before(child, i))
+	    return;
+	Swap(i, child);
+	i = child;
+    }
+}
+
+//----------------------------------------------------------------------
+// EventQueue::Insert
+// 	Add an item to the queue, after every item with the same key,
+//	doubling the heap array if it is full.
+//
+//	"item" is the event
+//	"key" is when it is due
+//----------------------------------------------------------------------
+
+void
+EventQueue::Insert(void *item, int key)
+{
+    if (numEntries == maxEntries) {
+	EventQueueEntry *bigger = new EventQueueEntry[2 * maxEntries];
+
+	for (int i = 0; i < numEntries; i++)
+	    bigger[i] = heap[i];
+	delete [] heap;
+	heap = bigger;
+	maxEntries *= 2;
+    }
+    heap[numEntries].item = item;
+    heap[numEntries].key = key;
+    heap[numEntries].order = numInserted++;
+    numEntries++;
+    SiftUp(numEntries - 1);
+}
+
+//----------------------------------------------------------------------
+// EventQueue::Peek
+// 	Return the earliest item, leaving it on the queue, and store its
+//	key in "*keyPtr".  Returns NULL (and leaves *keyPtr alone) if the
+//	queue is empty.
+//----------------------------------------------------------------------
+
+void *
+EventQueue::Peek(int *keyPtr)
+{
+    if (numEntries == 0)
+	return NULL;
+    *keyPtr = heap[0].key;
+    return heap[0].item;
+}
+
+//----------------------------------------------------------------------
+// EventQueue::Remove
+// 	Take the earliest item off the queue, and store its key in 
+//	"*keyPtr".  Returns NULL if the queue is empty.
+//----------------------------------------------------------------------
+
+void *
+EventQueue::Remove(int *keyPtr)
+{
+    void *item;
+
+    if (numEntries == 0)
+	return NULL;
+    item = heap[0].item;
+    *keyPtr = heap[0].key;
+    heap[0] = heap[--numEntries];
+    SiftDown(0);
+    return item;
+}
+
+//----------------------------------------------------------------------
+// EventQueue::Remove
+// 	Take "item" off the queue, wherever it is.  Finding it takes a 
+//	linear search, for cancelling an event, which is rare.
+//
+//	Returns FALSE if the item is not on the queue.
+//----------------------------------------------------------------------
+
+bool
+EventQueue::Remove(void *item)
+{
+    for (int i = 0; i < numEntries; i++)
+	if (heap[i].item == item) {
+	    heap[i] = heap[--numEntries];
+	    if (i < numEntries) {	// the last entry moved into the hole
+		SiftUp(i);
+		SiftDown(i);
+	    }
+	    return TRUE;
+	}
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// EventQueue::Mapcar
+// 	Apply a function to every item on the queue, in heap order.
+//
+//	"func" is the procedure to apply to each item
+//----------------------------------------------------------------------
+
+void
+EventQueue::Mapcar(VoidFunctionPtr func)
+{
+    for (int i = 0; i < numEntries; i++)
+	(*func)((int) heap[i].item);
+}
@@ -0,0 +1,60 @@
+// eventqueue.h 
+//	Data structures for a priority queue of events -- the pending 
+//	interrupts -- ordered by the simulated time they are due.
+//
+//	The queue is a binary heap in an array that grows as needed, so
+//	inserting or removing an event takes O(log n) time and no 
+//	allocation, and the earliest event can be looked at without 
+//	taking it off.  Events due at the same time come off in the order
+//	they were inserted.
+//
+//	Like a List, the queue holds "void *" items, each with an integer
+//	key.
+
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class EventQueueEntry {
+  public:
+    void *item;			// the event
+    int key;			// when it is due
+    unsigned int order;		// insertion count, to break ties
+};
+
+class EventQueue {
+  public:
+    EventQueue();		// initialize an empty queue
+    ~EventQueue();		// de-allocate it (but not the items)
+
+    void Insert(void *item, int key);	// add "item", due at "key"
+    void *Peek(int *keyPtr);	// the earliest item, and its key, 
+				// without removing it; NULL if empty
+    void *Remove(int *keyPtr);	// take the earliest item off the queue
+    bool Remove(void *item);	// take "item" off, wherever it is;
+				// FALSE if it is not on the queue
+
+    bool IsEmpty() { return (numEntries == 0); }
+    int NumEntries() { return numEntries; }
+    void *Nth(int n) { return heap[n].item; }
+				// every item, for 0 <= n < NumEntries(),
+				// in no particular order
+    void Mapcar(VoidFunctionPtr func);	// apply "func" to every item,
+					// in the same order
+
+  private:
+    EventQueueEntry *heap;	// heap[0] is the earliest; the children
+				// of heap[i] are heap[2i+1] and heap[2i+2]
+    int numEntries;
+    int maxEntries;		// size of the heap array
+    unsigned int numInserted;	// to set "order"
+
+    bool Before(int a, int b);	// should heap[a] come off before heap[b]?
+    void Swap(int a, int b);
+    void SiftUp(int i);		// restore the heap order after heap[i]
+    void SiftDown(int i);	// got earlier or later
+};
+
+#endif // EVENTQUEUE_H
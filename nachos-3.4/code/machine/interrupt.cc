@@ -23,12 +23,27 @@
 #include "copyright.h"
 #include "interrupt.h"
 #include "system.h"
+#include "slab.h"
+#ifdef USER_PROGRAM
+#include "profile.h"
+#include "cache.h"
+#include "costmodel.h"
+#endif
 
 // String definitions for debugging messages
 
 static char *intLevelNames[] = { "off", "on"};
 static char *intTypeNames[] = { "timer", "disk", "console write", 
-			"console read", "network send", "network recv"};
+			"console read", "network send", "network recv", "alarm",
+			"checkpoint", "fast forward"};
+
+// Every device operation schedules a pending interrupt
+static SlabCache pendingCache("pending interrupt", sizeof(PendingInterrupt));
+
+void *PendingInterrupt::operator new(size_t size)
+{ return pendingCache.Alloc(size); }
+void PendingInterrupt::operator delete(void *p)
+{ pendingCache.Free(p); }
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -60,10 +75,14 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time,
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
+    pending = new EventQueue();
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
+    interrupted = SystemMode;
+    fastForward = FALSE;
+    numHostIO = 0;
+    nextIOCheck = 0;
 }
 
 //----------------------------------------------------------------------
@@ -73,8 +92,10 @@ Interrupt::Interrupt()
 
 Interrupt::~Interrupt()
 {
+    int when;
+
     while (!pending->IsEmpty())
-	delete (PendingInterrupt *)pending->Remove();
+	delete (PendingInterrupt *)pending->Remove(&when);
     delete pending;
 }
 
@@ -166,6 +187,8 @@ Interrupt::OneTick()
     ChangeLevel(IntOn, IntOff);		// first, turn off interrupts
 					// (interrupt handlers run with
 					// interrupts disabled)
+    if (WaitingForIO() && (stats->totalTicks >= nextIOCheck))
+	CheckIO(FALSE);			// look for input from the host
     while (CheckIfDue(FALSE))		// check for pending interrupts
 	;
     ChangeLevel(IntOff, IntOn);		// re-enable interrupts
@@ -178,6 +201,31 @@ Interrupt::OneTick()
     }
 }
 
+//----------------------------------------------------------------------
+// Interrupt::NextDueTime
+// 	Return the simulated time at which OneTick will next do anything
+//	besides advancing the clock.  Until then the CPU may charge its
+//	own ticks (see Machine::ChargeTick).
+//
+//	That is when the earliest pending interrupt is due, or when to
+//	next look for host input if a device is waiting for some, unless
+//	the 'i' debug flag traces every tick.
+//----------------------------------------------------------------------
+
+int
+Interrupt::NextDueTime()
+{
+    int when;
+
+    if (DebugIsEnabled('i'))
+	return stats->totalTicks;
+    if (pending->Peek(&when) == NULL)
+	when = NeverDue;
+    if (WaitingForIO() && (nextIOCheck < when))
+	return nextIOCheck;
+    return when;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::YieldOnReturn
 // 	Called from within an interrupt handler, to cause a context switch
@@ -204,6 +252,10 @@ Interrupt::YieldOnReturn()
 //	on the ready queue, the only thing to do is to advance 
 //	simulated time until the next scheduled hardware interrupt.
 //
+//	If a device is waiting for host input (the keyboard, say) and
+//	nothing but the timer is pending, wait for the input first;
+//	simulated time then jumps to when it arrives.
+//
 //	If there are no pending interrupts, stop.  There's nothing
 //	more for us to do.
 //----------------------------------------------------------------------
@@ -212,6 +264,8 @@ Interrupt::Idle()
 {
     DEBUG('i', "Machine idling; checking for interrupts.\n");
     status = IdleMode;
+    if (WaitingForIO())
+	CheckIO(NothingPending());
     if (CheckIfDue(TRUE)) {		// check for any pending interrupts
     	while (CheckIfDue(FALSE))	// check for any other pending 
 	    ;				// interrupts
@@ -224,8 +278,8 @@ Interrupt::Idle()
 
     // if there are no pending interrupts, and nothing is on the ready
     // queue, it is time to stop.   If the console or the network is 
-    // operating, there are *always* pending interrupts, so this code
-    // is not reached.  Instead, the halt must be invoked by the user program.
+    // operating, we wait for its input above, so this code is not
+    // reached.  Instead, the halt must be invoked by the user program.
 
     DEBUG('i', "Machine idle.  No interrupts to do.\n");
     printf("No threads ready or runnable, and no pending interrupts.\n");
@@ -235,13 +289,29 @@ Interrupt::Idle()
 
 //----------------------------------------------------------------------
 // Interrupt::Halt
-// 	Shut down Nachos cleanly, printing out performance statistics.
+// 	Shut down Nachos cleanly, printing out performance statistics
+//	(and the cache statistics and user program profile, if we were
+//	simulating caches or profiling).
 //----------------------------------------------------------------------
 void
 Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+    if (DebugIsEnabled('k'))
+	SlabCache::PrintAll();
+#ifdef USER_PROGRAM
+    if ((machine != NULL) && (machine->icache != NULL)) {
+	machine->icache->Print();
+	machine->dcache->Print();
+	if (machine->l2cache != NULL)
+	    machine->l2cache->Print();
+    }
+    if ((machine != NULL) && (machine->costModel != NULL))
+	machine->costModel->Print();
+    if ((machine != NULL) && (machine->profiler != NULL))
+	machine->profiler->Print();
+#endif
     Cleanup();     // Never returns.
 }
 
@@ -250,7 +320,8 @@ Interrupt::Halt()
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: just put it on the event queue, behind any
+//	interrupts already scheduled for the same time.
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
@@ -271,7 +342,152 @@ Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
 					intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    pending->Insert(toOccur, when);
+}
+
+//----------------------------------------------------------------------
+// Interrupt::WatchIO
+// 	Interrupt "delay" ticks after the host file "fd" has input,
+//	by calling "handler" with "arg".  This replaces a device polling
+//	the file with an interrupt every few ticks, which kept an idle
+//	Nachos from ever skipping ahead.
+//
+//	Implementation: the host tells us which files are readable (see
+//	WaitForFiles).  A busy CPU asks every HostIOTime ticks; an idle
+//	one waits to be told.
+//----------------------------------------------------------------------
+
+void
+Interrupt::WatchIO(int fd, VoidFunctionPtr handler, int arg, int delay,
+	IntType type)
+{
+    HostIO *io = &hostIO[numHostIO++];
+
+    ASSERT(numHostIO <= MaxHostIO);
+    io->fd = fd;
+    io->handler = handler;
+    io->arg = arg;
+    io->delay = delay;
+    io->type = type;
+    io->armed = FALSE;
+    ArmIO(fd);
+}
+
+//----------------------------------------------------------------------
+// Interrupt::ArmIO
+// 	The device for host file "fd" has taken its input, and has room
+//	for more: interrupt again when there is some.
+//----------------------------------------------------------------------
+
+void
+Interrupt::ArmIO(int fd)
+{
+    for (int i = 0; i < numHostIO; i++)
+	if ((hostIO[i].fd == fd) && !hostIO[i].armed) {
+	    hostIO[i].armed = TRUE;
+	    nextIOCheck = stats->totalTicks + HostIOTime;
+	    WatchFile(fd);
+	}
+}
+
+//----------------------------------------------------------------------
+// Interrupt::IgnoreIO
+// 	Stop watching the host file "fd"; its device is going away.
+//----------------------------------------------------------------------
+
+void
+Interrupt::IgnoreIO(int fd)
+{
+    for (int i = 0; i < numHostIO; i++)
+	if (hostIO[i].fd == fd) {
+	    hostIO[i] = hostIO[--numHostIO];
+	    IgnoreFile(fd);
+	    return;
+	}
+}
+
+//----------------------------------------------------------------------
+// Interrupt::CheckIO
+// 	Schedule the interrupt for every watched host file that has
+//	input.
+//
+//	"block" -- if TRUE, wait until some file has input
+//----------------------------------------------------------------------
+
+void
+Interrupt::CheckIO(bool block)
+{
+    int ready[MaxHostIO];
+    int numReady = WaitForFiles(ready, MaxHostIO, block);
+
+    nextIOCheck = stats->totalTicks + HostIOTime;
+    for (int n = 0; n < numReady; n++)
+	for (int i = 0; i < numHostIO; i++)
+	    if ((hostIO[i].fd == ready[n]) && hostIO[i].armed) {
+		DEBUG('i', "Host input for the %s\n", 
+					intTypeNames[hostIO[i].type]);
+		hostIO[i].armed = FALSE;
+		Schedule(hostIO[i].handler, hostIO[i].arg, hostIO[i].delay,
+				hostIO[i].type);
+	    }
+}
+
+//----------------------------------------------------------------------
+// Interrupt::WaitingForIO, Interrupt::NothingPending
+// 	Is some device ready to take host input?  Is there nothing
+//	pending but interrupts that cannot make a thread ready to run
+//	(time slices, checkpoints, the end of fast-forward), so that an
+//	idle machine has nothing left to do?
+//----------------------------------------------------------------------
+
+bool
+Interrupt::WaitingForIO()
+{
+    for (int i = 0; i < numHostIO; i++)
+	if (hostIO[i].armed)
+	    return TRUE;
+    return FALSE;
+}
+
+bool
+Interrupt::NothingPending()
+{
+    for (int i = 0; i < pending->NumEntries(); i++) {
+	IntType type = ((PendingInterrupt *) pending->Nth(i))->type;
+
+	if ((type != TimerInt) && (type != CheckpointInt) 
+				&& (type != FastForwardInt))
+	    return FALSE;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Cancel
+// 	Take back the earliest scheduled interrupt that would call
+//	"handler" with "arg", as when a device is turned off.  Return
+//	FALSE if there is none.
+//----------------------------------------------------------------------
+
+bool
+Interrupt::Cancel(VoidFunctionPtr handler, int arg)
+{
+    PendingInterrupt *found = NULL;
+
+    for (int i = 0; i < pending->NumEntries(); i++) {
+	PendingInterrupt *p = (PendingInterrupt *) pending->Nth(i);
+
+	if ((p->handler == handler) && (p->arg == arg) &&
+		((found == NULL) || (p->when < found->when)))
+	    found = p;
+    }
+    if (found == NULL)
+	return FALSE;
+    DEBUG('i', "Cancelling interrupt handler the %s at time = %d\n", 
+					intTypeNames[found->type], found->when);
+    (void) pending->Remove((void *) found);
+    delete found;
+    return TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -284,8 +500,8 @@ Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
 //	"advanceClock" -- if TRUE, there is nothing in the ready queue,
 //		so we should simply advance the clock to when the next 
 //		pending interrupt would occur (if any).  If the pending
-//		interrupt is just the time-slice daemon, however, then 
-//		we're done!
+//		interrupts are just the time-slice daemon (and others that
+//		cannot wake a thread up), however, then we're done!
 //----------------------------------------------------------------------
 bool
 Interrupt::CheckIfDue(bool advanceClock)
@@ -298,7 +514,7 @@ Interrupt::CheckIfDue(bool advanceClock)
     if (DebugIsEnabled('i'))
 	DumpState();
     PendingInterrupt *toOccur = 
-		(PendingInterrupt *)pending->SortedRemove(&when);
+		(PendingInterrupt *)pending->Peek(&when);
 
     if (toOccur == NULL)		// no pending interrupts
 	return FALSE;			
@@ -306,17 +522,13 @@ Interrupt::CheckIfDue(bool advanceClock)
     if (advanceClock && when > stats->totalTicks) {	// advance the clock
 	stats->idleTicks += (when - stats->totalTicks);
 	stats->totalTicks = when;
-    } else if (when > stats->totalTicks) {	// not time yet, put it back
-	pending->SortedInsert(toOccur, when);
+    } else if (when > stats->totalTicks)	// not time yet
 	return FALSE;
-    }
 
 // Check if there is nothing more to do, and if so, quit
-    if ((status == IdleMode) && (toOccur->type == TimerInt) 
-				&& pending->IsEmpty()) {
-	 pending->SortedInsert(toOccur, when);
+    if ((status == IdleMode) && NothingPending())
 	 return FALSE;
-    }
+    (void) pending->Remove(&when);
 
     DEBUG('i', "Invoking interrupt handler for the %s at time %d\n", 
 			intTypeNames[toOccur->type], toOccur->when);
@@ -325,6 +537,7 @@ Interrupt::CheckIfDue(bool advanceClock)
     	machine->DelayedLoad(0, 0);
 #endif
     inHandler = TRUE;
+    interrupted = status;
     status = SystemMode;			// whatever we were doing,
 						// we are now going to be
 						// running in the kernel
@@ -367,3 +580,70 @@ Interrupt::DumpState()
     printf("End of pending interrupts\n");
     fflush(stdout);
 }
+
+//----------------------------------------------------------------------
+// Interrupt::Checkpoint
+// 	Write the pending interrupts to the open file "fd", as the type
+//	of device and how long from now each is due.  The handlers are
+//	not written: they are addresses in this run of Nachos.
+//----------------------------------------------------------------------
+
+void
+Interrupt::Checkpoint(int fd)
+{
+    int n = pending->NumEntries();
+
+    WriteFile(fd, (char *) &n, sizeof(n));
+    for (int i = 0; i < n; i++) {
+	PendingInterrupt *p = (PendingInterrupt *) pending->Nth(i);
+	int saved[2];
+
+	saved[0] = p->type;
+	saved[1] = p->when - stats->totalTicks;
+	WriteFile(fd, (char *) saved, sizeof(saved));
+    }
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Restore
+// 	Read the interrupts written by Interrupt::Checkpoint, and re-time
+//	the ones the devices of this run have already scheduled: each
+//	pending interrupt takes the delay of a saved one from the same 
+//	device.  The others keep their delay from now.  
+//
+//	"now" -- the simulated time being restored; stats->totalTicks is
+//		updated to it by the caller afterwards
+//----------------------------------------------------------------------
+
+void
+Interrupt::Restore(int fd, int now)
+{
+    EventQueue *old = pending;
+    PendingInterrupt *p;
+    int n, when, i;
+
+    Read(fd, (char *) &n, sizeof(n));
+    int *saved = new int[2 * n];	// type and delay, -1 once used
+    Read(fd, (char *) saved, 2 * n * sizeof(int));
+
+    pending = new EventQueue();
+    while ((p = (PendingInterrupt *) old->Remove(&when)) != NULL) {
+	for (i = 0; i < n; i++)
+	    if (saved[2 * i] == p->type)
+		break;
+	if (i < n) {
+	    p->when = now + saved[2 * i + 1];
+	    saved[2 * i] = -1;
+	} else
+	    p->when = now + (p->when - stats->totalTicks);
+	DEBUG('i', "Restored interrupt for the %s at time %d\n", 
+			intTypeNames[p->type], p->when);
+	pending->Insert(p, p->when);
+    }
+    for (i = 0; i < n; i++)
+	if (saved[2 * i] != -1)
+	    printf("Restore: no %s is pending in this run, dropped\n",
+			intTypeNames[saved[2 * i]]);
+    delete old;
+    delete [] saved;
+}
@@ -36,7 +36,7 @@
 #define INTERRUPT_H
 
 #include "copyright.h"
-#include "list.h"
+#include "eventqueue.h"
 
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
 enum IntStatus { IntOff, IntOn };
@@ -47,10 +47,13 @@ enum IntStatus { IntOff, IntOn };
 enum MachineStatus {IdleMode, SystemMode, UserMode};
 
 // IntType records which hardware device generated an interrupt.
-// In Nachos, we support a hardware timer device, a disk, a console
-// display and keyboard, and a network.
+// In Nachos, we support a hardware timer device (with a one-shot
+// alarm), a disk, a console display and keyboard, and a network.
+// CheckpointInt and FastForwardInt are the simulator's own, for writing
+// a checkpoint and for ending the fast-forward phase (-ff).
 enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt, 
-				NetworkSendInt, NetworkRecvInt};
+				NetworkSendInt, NetworkRecvInt, AlarmInt,
+				CheckpointInt, FastForwardInt};
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
@@ -62,6 +65,9 @@ class PendingInterrupt {
 				// initialize an interrupt that will
 				// occur in the future
 
+    void *operator new(size_t size);	// allocated from a slab cache,
+    void operator delete(void *p);	// see slab.h
+
     VoidFunctionPtr handler;    // The function (in the hardware device
 				// emulator) to call when the interrupt occurs
     int arg;                    // The argument to the function.
@@ -69,6 +75,26 @@ class PendingInterrupt {
     IntType type;		// for debugging
 };
 
+#define NeverDue	0x7fffffff	// NextDueTime() with nothing pending
+
+// A host file that a device gets its input from (the keyboard, or a
+// network socket).  When the file has input, the device's interrupt
+// is scheduled "delay" ticks later; then the file is not watched
+// again until the device has room for more input (see ArmIO).
+
+class HostIO {
+  public:
+    int fd;			// UNIX file to watch
+    VoidFunctionPtr handler;	// interrupt to schedule when it has input
+    int arg;
+    int delay;			// how long after the input arrives
+    IntType type;
+    bool armed;			// is the device ready for more input?
+};
+
+#define MaxHostIO	8	// devices that can take host input
+#define HostIOTime	100	// how often a busy CPU looks for host input
+
 // The following class defines the data structures for the simulation
 // of hardware interrupts.  We record whether interrupts are enabled
 // or disabled, and any hardware interrupts that are scheduled to occur
@@ -96,6 +122,9 @@ class Interrupt {
 					// from an interrupt handler
 
     MachineStatus getStatus() { return status; } // idle, kernel, user
+    MachineStatus getInterruptedStatus() { return interrupted; }
+					// what the CPU was doing when the
+					// running interrupt handler was called
     void setStatus(MachineStatus st) { status = st; }
 
     void DumpState();			// Print interrupt state
@@ -109,22 +138,49 @@ class Interrupt {
     void Schedule(VoidFunctionPtr handler,// Schedule an interrupt to occur
 	int arg, int when, IntType type);// at time ``when''.  This is called
     					// by the hardware device simulators.
+    bool Cancel(VoidFunctionPtr handler, int arg);
+					// Take a scheduled interrupt back
     
     void OneTick();       		// Advance simulated time
 
+    int NextDueTime();			// When OneTick next has work to do
+
+    void SetFastForward(bool on) { fastForward = on; }
+    bool FastForwarding() { return fastForward; }
+					// TRUE while user programs run without
+					// timing detail (see Machine::Run)
+
+    void Checkpoint(int fd);		// Save the pending interrupts, and
+    void Restore(int fd, int now);	// re-time this run's to match
+
+    void WatchIO(int fd, VoidFunctionPtr handler, int arg, int delay,
+	IntType type);			// Interrupt when "fd" has input,
+    void ArmIO(int fd);			// and again once the device has
+					// taken it
+    void IgnoreIO(int fd);		// Stop watching "fd"
+
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    List *pending;		// the list of interrupts scheduled
-				// to occur in the future
+    EventQueue *pending;	// the interrupts scheduled to occur
+				// in the future, earliest first
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
     MachineStatus status;	// idle, kernel mode, user mode
+    MachineStatus interrupted;	// status before the current handler
+    bool fastForward;		// devices take the shortest possible time
+    HostIO hostIO[MaxHostIO];	// the files devices take input from
+    int numHostIO;
+    int nextIOCheck;		// when a busy CPU next looks for input
 
     // these functions are internal to the interrupt simulation code
 
     bool CheckIfDue(bool advanceClock); // Check if an interrupt is supposed
 					// to occur now
+    void CheckIO(bool block);		// Schedule interrupts for host input
+    bool WaitingForIO();		// Is any device ready for input?
+    bool NothingPending();		// Is nothing due that could wake
+					// up a thread?
 
     void ChangeLevel(IntStatus old, 	// SetLevel, without advancing the
 	IntStatus now);  		// simulated time
@@ -0,0 +1,364 @@
+// jit.cc 
+//	Routines to translate hot blocks of user code into MicroOps, and 
+//	to run them (Machine::RunTranslated).
+//
+//	The host routines below must compute exactly what the interpreter
+//	does in mipsexec.h -- including its quirks -- or the two engines
+//	would no longer give the same results.
+
+#include "copyright.h"
+#include "jit.h"
+#include "mipssim.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// Host routines for the instructions we specialise.  None of these can
+// raise an exception or change the flow of control.
+//----------------------------------------------------------------------
+
+static void OpAdd(MicroOp *op)  { *op->dst = *op->src1 + *op->src2; }
+static void OpAddI(MicroOp *op) { *op->dst = *op->src1 + op->imm; }
+static void OpSub(MicroOp *op)  { *op->dst = *op->src1 - *op->src2; }
+static void OpAnd(MicroOp *op)  { *op->dst = *op->src1 & *op->src2; }
+static void OpAndI(MicroOp *op) { *op->dst = *op->src1 & op->imm; }
+static void OpOr(MicroOp *op)   { *op->dst = *op->src1 | *op->src2; }
+static void OpOrI(MicroOp *op)  { *op->dst = *op->src1 | op->imm; }
+static void OpXor(MicroOp *op)  { *op->dst = *op->src1 ^ *op->src2; }
+static void OpXorI(MicroOp *op) { *op->dst = *op->src1 ^ op->imm; }
+static void OpNor(MicroOp *op)  { *op->dst = ~(*op->src1 | *op->src2); }
+static void OpMove(MicroOp *op) { *op->dst = *op->src1; }
+static void OpLoadI(MicroOp *op) { *op->dst = op->imm; }
+
+static void OpShiftLeft(MicroOp *op)  { *op->dst = *op->src1 << op->imm; }
+static void OpShiftRight(MicroOp *op) { *op->dst = *op->src1 >> op->imm; }
+static void OpShiftLeftV(MicroOp *op) 
+{ *op->dst = *op->src1 << (*op->src2 & 0x1f); }
+static void OpShiftRightV(MicroOp *op) 
+{ *op->dst = *op->src1 >> (*op->src2 & 0x1f); }
+
+static void OpSetLess(MicroOp *op)  { *op->dst = (*op->src1 < *op->src2); }
+static void OpSetLessI(MicroOp *op) { *op->dst = (*op->src1 < op->imm); }
+static void OpSetLessU(MicroOp *op)
+{ *op->dst = ((unsigned int) *op->src1 < (unsigned int) *op->src2); }
+static void OpSetLessIU(MicroOp *op)
+{ *op->dst = ((unsigned int) *op->src1 < (unsigned int) op->imm); }
+
+//----------------------------------------------------------------------
+// TranslateOne
+// 	Fill in the MicroOp for one decoded instruction.  Leave "handler"
+//	NULL if the instruction has to be interpreted.
+//
+//	"op" -- the MicroOp to fill in
+//	"instr" -- the decoded instruction
+//	"r" -- the register file of the CPU that will run it
+//----------------------------------------------------------------------
+
+static void
+TranslateOne(MicroOp *op, Instruction *instr, int *r)
+{
+    op->handler = NULL;
+    op->instr = instr;
+    op->dst = op->src1 = op->src2 = NULL;
+    op->imm = instr->extra;
+
+    switch (instr->opCode) {
+      case OP_ADDU:	op->handler = OpAdd;	break;
+      case OP_SUBU:	op->handler = OpSub;	break;
+      case OP_AND:	op->handler = OpAnd;	break;
+      case OP_XOR:	op->handler = OpXor;	break;
+      case OP_NOR:	op->handler = OpNor;	break;
+      case OP_SLT:	op->handler = OpSetLess;	break;
+      case OP_SLTU:	op->handler = OpSetLessU;	break;
+      case OP_OR:			// the interpreter ORs rs with itself
+	op->handler = OpOr;
+	op->dst = &r[(int) instr->rd];
+	op->src1 = op->src2 = &r[(int) instr->rs];
+	return;
+
+      case OP_ADDIU:	op->handler = OpAddI;	break;
+      case OP_SLTI:	op->handler = OpSetLessI;	break;
+      case OP_SLTIU:	op->handler = OpSetLessIU;	break;
+      case OP_ANDI:
+	op->handler = OpAndI;
+	op->imm = instr->extra & 0xffff;
+	break;
+      case OP_ORI:
+	op->handler = OpOrI;
+	op->imm = instr->extra & 0xffff;
+	break;
+      case OP_XORI:
+	op->handler = OpXorI;
+	op->imm = instr->extra & 0xffff;
+	break;
+      case OP_LUI:
+	op->handler = OpLoadI;
+	op->imm = instr->extra << 16;
+	op->dst = &r[(int) instr->rt];
+	return;
+
+      case OP_SLL:	op->handler = OpShiftLeft;	break;
+      case OP_SRA:			// the interpreter's SRL shifts a
+      case OP_SRL:	op->handler = OpShiftRight;	break;	// signed int
+      case OP_SLLV:	op->handler = OpShiftLeftV;	break;
+      case OP_SRAV:
+      case OP_SRLV:	op->handler = OpShiftRightV;	break;
+
+      case OP_MFHI:
+	op->handler = OpMove;
+	op->dst = &r[(int) instr->rd];
+	op->src1 = &r[HiReg];
+	return;
+      case OP_MFLO:
+	op->handler = OpMove;
+	op->dst = &r[(int) instr->rd];
+	op->src1 = &r[LoReg];
+	return;
+
+      default:				// may trap or branch: interpret
+	return;
+    }
+
+    switch (instr->opCode) {
+      case OP_ADDIU: case OP_SLTI: case OP_SLTIU:
+      case OP_ANDI: case OP_ORI: case OP_XORI:
+	op->dst = &r[(int) instr->rt];
+	op->src1 = &r[(int) instr->rs];
+	break;
+      case OP_SLL: case OP_SRA: case OP_SRL:
+	op->dst = &r[(int) instr->rd];
+	op->src1 = &r[(int) instr->rt];
+	break;
+      case OP_SLLV: case OP_SRAV: case OP_SRLV:
+	op->dst = &r[(int) instr->rd];
+	op->src1 = &r[(int) instr->rt];
+	op->src2 = &r[(int) instr->rs];
+	break;
+      default:
+	op->dst = &r[(int) instr->rd];
+	op->src1 = &r[(int) instr->rs];
+	op->src2 = &r[(int) instr->rt];
+	break;
+    }
+}
+
+//----------------------------------------------------------------------
+// EndsBlock
+// 	Return TRUE if "instr" transfers control, so that the block ends 
+//	after its delay slot.
+//----------------------------------------------------------------------
+
+static bool
+EndsBlock(Instruction *instr)
+{
+    switch (instr->opCode) {
+      case OP_BEQ: case OP_BNE: case OP_BLEZ: case OP_BGTZ:
+      case OP_BLTZ: case OP_BGEZ: case OP_BLTZAL: case OP_BGEZAL:
+      case OP_J: case OP_JAL: case OP_JR: case OP_JALR:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// BlockTranslator::BlockTranslator
+// 	Initialize an empty set of blocks, for the CPU whose register
+//	file is "regs".
+//----------------------------------------------------------------------
+
+BlockTranslator::BlockTranslator(int *regs)
+{
+    registers = regs;
+    pageBlocks = new TranslatedBlock *[NumPhysPages];
+    generation = new int[NumPhysPages];
+    for (int i = 0; i < NumPhysPages; i++) {
+	pageBlocks[i] = NULL;
+	generation[i] = 0;
+    }
+    numTranslated = 0;
+}
+
+//----------------------------------------------------------------------
+// BlockTranslator::~BlockTranslator
+// 	Free every block.
+//----------------------------------------------------------------------
+
+BlockTranslator::~BlockTranslator()
+{
+    for (int i = 0; i < NumPhysPages; i++)
+	InvalidatePage(i);
+    delete [] pageBlocks;
+    delete [] generation;
+}
+
+//----------------------------------------------------------------------
+// BlockTranslator::Lookup
+// 	Return the block starting at "physAddr", creating it (cold, with
+//	a zero execution count) if it has not been seen since its page
+//	was last invalidated.
+//----------------------------------------------------------------------
+
+TranslatedBlock *
+BlockTranslator::Lookup(int physAddr)
+{
+    int page = physAddr / PageSize;
+    TranslatedBlock *block;
+
+    for (block = pageBlocks[page]; block != NULL; block = block->next)
+	if (block->physAddr == physAddr)
+	    return block;
+
+    block = new TranslatedBlock;
+    block->physAddr = physAddr;
+    block->count = 0;
+    block->length = 0;
+    block->ops = NULL;
+    block->next = pageBlocks[page];
+    pageBlocks[page] = block;
+    return block;
+}
+
+//----------------------------------------------------------------------
+// BlockTranslator::Translate
+// 	Translate a hot block.  The block ends after the delay slot of the
+//	first control transfer, after a syscall, at the end of the page, 
+//	or after MaxBlockLength instructions, whichever comes first.
+//
+//	"block" -- the block to translate
+//	"code" -- the decoded instructions, starting at block->physAddr
+//	"maxLength" -- the number of instructions left in the page
+//----------------------------------------------------------------------
+
+void
+BlockTranslator::Translate(TranslatedBlock *block, Instruction *code, 
+			int maxLength)
+{
+    int length;
+
+    maxLength = min(maxLength, MaxBlockLength);
+    for (length = 0; length < maxLength; ) {
+	Instruction *instr = &code[length++];
+	if (EndsBlock(instr)) {
+	    if (length < maxLength)
+		length++;		// include the delay slot
+	    break;
+	}
+	if (instr->opCode == OP_SYSCALL)
+	    break;
+    }
+
+    block->ops = new MicroOp[length];
+    for (int i = 0; i < length; i++)
+	TranslateOne(&block->ops[i], &code[i], registers);
+    block->length = length;
+    numTranslated++;
+    DEBUG('m', "Translated block at physical 0x%x, %d instructions\n",
+	  block->physAddr, length);
+}
+
+//----------------------------------------------------------------------
+// BlockTranslator::InvalidatePage
+// 	Throw away every block (hot or cold) of a physical page, because
+//	the page has been written or replaced.
+//----------------------------------------------------------------------
+
+void
+BlockTranslator::InvalidatePage(int physPage)
+{
+    TranslatedBlock *block, *next;
+
+    for (block = pageBlocks[physPage]; block != NULL; block = next) {
+	next = block->next;
+	if (block->ops != NULL)
+	    delete [] block->ops;
+	delete block;
+    }
+    pageBlocks[physPage] = NULL;
+    generation[physPage]++;
+}
+
+//----------------------------------------------------------------------
+// Machine::RunTranslated
+// 	Execute the block of user code at the current PC.  Cold blocks are
+//	interpreted (and counted); hot blocks are translated once and then
+//	run from their MicroOps.
+//
+//	Each instruction still advances simulated time by one tick, and
+//	still sets the use bit (and the TLB hit count) of the page it is 
+//	fetched from, so the statistics -- and the page replacement 
+//	decisions that depend on them -- match the interpreter exactly.
+//	We leave the block as soon as anything the translation relies on
+//	may have changed: an exception, a context switch that replaced
+//	our translation, or the page being written.
+//----------------------------------------------------------------------
+
+void
+Machine::RunTranslated()
+{
+    int virtStart = registers[PCReg];
+    int physAddr, page, gen, length, vpn, ppn;
+    ExceptionType exception;
+    TranslationEntry *entry;
+    TranslatedBlock *block;
+    MicroOp *ops;
+
+    exception = Translate(virtStart, &physAddr, 4, FALSE);
+    if (exception != NoException) {
+	RaiseException(exception, virtStart);
+	ChargeTick();
+	return;
+    }
+    entry = lastEntry;
+    page = physAddr / PageSize;
+    if (!pageDecoded[page])
+	DecodePage(page);
+
+    block = translator->Lookup(physAddr);
+    if (block->length == 0) {
+	if (++block->count < JitThreshold) {	// still cold: interpret
+	    bool retired = ExecuteInstruction(&decodedMemory[physAddr / 4]);
+
+	    ChargeTick();
+	    if (!retired)
+		return;			// exception occurred
+	    if (registers[PCReg] == virtStart + 4)
+		RunBlock();
+	    return;
+	}
+	translator->Translate(block, &decodedMemory[physAddr / 4],
+			      (PageSize - physAddr % PageSize) / 4);
+    }
+
+    gen = translator->Generation(page);
+    length = block->length;
+    ops = block->ops;
+    vpn = entry->virtualPage;
+    ppn = entry->physicalPage;
+    for (int i = 0; ; ) {
+	MicroOp *op = &ops[i];
+
+	if (op->handler != NULL) {
+	    (*op->handler)(op);
+	    DelayedLoad(0, 0);
+	    registers[PrevPCReg] = registers[PCReg];
+	    registers[PCReg] = registers[NextPCReg];
+	    registers[NextPCReg] = registers[PCReg] + 4;
+	} else if (!ExecuteInstruction(op->instr)) {
+	    ChargeTick();
+	    return;				// exception occurred
+	}
+	ChargeTick();
+
+	if (++i == length)
+	    return;
+	if ((translator->Generation(page) != gen) ||	// page changed
+	    (registers[PCReg] != virtStart + 4 * i) ||	// left the block
+	    !entry->valid || (entry->virtualPage != vpn) ||
+	    (entry->physicalPage != ppn) || (entry->asid != asid))
+	    return;					// mapping changed
+
+	entry->use = TRUE;			// fetch of the next instruction
+	if (tlb != NULL)
+	    entry->hit++;
+    }
+}
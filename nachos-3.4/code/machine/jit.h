@@ -0,0 +1,90 @@
+// jit.h 
+//	Data structures for translating frequently executed blocks of 
+//	user code, so that they can be run without fetching, translating
+//	and decoding every instruction again.
+//
+//	A block is a straight run of instructions within one physical
+//	page, up to and including the delay slot of the first control
+//	transfer (or a syscall).  Each block has an execution counter;
+//	once a block has been entered JitThreshold times it is translated
+//	into an array of MicroOps.  A MicroOp is a pointer to a host routine
+//	specialised for one instruction, with its register operands 
+//	already resolved to host addresses.  Instructions that can raise
+//	an exception or change the flow of control are not specialised:
+//	they are run through Machine::ExecuteInstruction, so that TLB
+//	misses, syscalls and overflows still trap precisely.
+//
+//	Nachos itself is built as a 32-bit i386 program, so rather than 
+//	emitting host machine code we translate into these pre-resolved
+//	host routines, which removes the fetch, decode and dispatch work 
+//	without tying the simulator to one host instruction set.
+
+#ifndef JIT_H
+#define JIT_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "machine.h"
+
+#define JitThreshold	16	// entries before a block is translated
+#define MaxBlockLength	64	// longest block we will translate
+
+class MicroOp;
+typedef void (*MicroOpHandler)(MicroOp *op);
+
+// One translated instruction.  If "handler" is NULL, the instruction is
+// executed by the interpreter from "instr".
+
+class MicroOp {
+  public:
+    MicroOpHandler handler;	// host routine for the instruction
+    Instruction *instr;		// the decoded instruction
+    int *dst;			// register written
+    int *src1;			// registers read
+    int *src2;
+    int imm;			// immediate operand, already extended
+};
+
+// The execution counter, and once it is hot, the translation, of one
+// block of user code.
+
+class TranslatedBlock {
+  public:
+    int physAddr;		// physical address of the first instruction
+    int count;			// number of times the block was entered
+    int length;			// number of instructions translated,
+				// 0 until the block is hot
+    MicroOp *ops;		// the translation
+    TranslatedBlock *next;	// next block in the same physical page
+};
+
+// The following class keeps track of all blocks, by physical page, so
+// that they can be thrown away when the page is written or replaced.
+
+class BlockTranslator {
+  public:
+    BlockTranslator(int *regs);	// no blocks yet; translate for the
+				// CPU whose register file is "regs"
+    ~BlockTranslator();		// free all blocks
+
+    TranslatedBlock *Lookup(int physAddr);
+				// Find the block starting at "physAddr",
+				// creating a new (cold) one if necessary
+    void Translate(TranslatedBlock *block, Instruction *code, int maxLength);
+				// Translate a hot block, whose decoded
+				// instructions start at "code"
+    void InvalidatePage(int physPage);
+				// Throw away the blocks of a physical page
+    int Generation(int physPage) { return generation[physPage]; }
+				// Changes whenever the page's blocks are
+				// thrown away
+
+    int numTranslated;		// number of blocks translated so far
+
+  private:
+    int *registers;		// register file the MicroOps point into
+    TranslatedBlock **pageBlocks;	// blocks of each physical page
+    int *generation;		// bumped by InvalidatePage
+};
+
+#endif // JIT_H
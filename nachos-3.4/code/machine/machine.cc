@@ -9,6 +9,11 @@
 
 #include "copyright.h"
 #include "machine.h"
+#include "jit.h"
+#include "profile.h"
+#include "cache.h"
+#include "trace.h"
+#include "costmodel.h"
 #include "system.h"
 
 // Textual names of the exceptions that can be generated by user program
@@ -44,35 +49,70 @@ void CheckEndian()
 #endif
 }
 
+// The geometry of the simulated machine; it must be set before the
+// Machine is created, and never changed afterwards.
+
+int pageSize = DefaultPageSize;
+int numPhysPages = DefaultNumPhysPages;
+int tlbSize = DefaultTLBSize;
+int tlbWays = DefaultTLBWays;
+
 //----------------------------------------------------------------------
 // Machine::Machine
 // 	Initialize the simulation of user program execution.
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"whichEngine" -- the engine Run() uses to execute user instructions
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, ExecEngine whichEngine)
 {
     int i;
 
+    ASSERT((PageSize > 0) && (PageSize % 4 == 0));
+    ASSERT((NumPhysPages > 0) && (TLBSize > 0));
+    if ((TLBWays <= 0) || (TLBWays > TLBSize))
+	tlbWays = TLBSize;		// fully associative
+    ASSERT(TLBSize % TLBWays == 0);
     for (i = 0; i < NumTotalRegs; i++)
         registers[i] = 0;
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
       	mainMemory[i] = 0;
+    decodedMemory = new Instruction[MemorySize / 4];
+    pageDecoded = new bool[NumPhysPages];
+    for (i = 0; i < NumPhysPages; i++)
+	pageDecoded[i] = FALSE;
 #ifdef USE_TLB
     tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
+    for (i = 0; i < TLBSize; i++) {
 	tlb[i].valid = FALSE;
-    tlb[i].hit = 0;
+	tlb[i].hit = 0;
+	tlb[i].asid = 0;
+    }
     pageTable = NULL;
 #else	// use linear page table
     tlb = NULL;
     pageTable = NULL;
 #endif
+    pageDirectory = NULL;
 
     singleStep = debug;
+    engine = whichEngine;
+    translator = NULL;
+    if (engine == JitEngine)
+	translator = new BlockTranslator(registers);
+    lastEntry = NULL;
+    asid = 0;
+    profiler = NULL;
+    icache = dcache = l2cache = NULL;
+    tracer = NULL;
+    costModel = NULL;
+    fastForwardEnd = NeverDue;
+    quietTicks = 0;
+    hostTLBEnabled = !DebugIsEnabled('a');	// keep the full 'a' trace
+    FlushHostTLB();
     CheckEndian();
 }
 
@@ -84,10 +124,124 @@ Machine::Machine(bool debug)
 Machine::~Machine()
 {
     delete [] mainMemory;
+    delete [] decodedMemory;
+    delete [] pageDecoded;
+    if (translator != NULL)
+	delete translator;
+    if (profiler != NULL)
+	delete profiler;
+    if (icache != NULL)
+	delete icache;
+    if (dcache != NULL)
+	delete dcache;
+    if (l2cache != NULL)
+	delete l2cache;
+    if (tracer != NULL)
+	delete tracer;			// writes out the end of the trace
+    if (costModel != NULL)
+	delete costModel;
     if (tlb != NULL)
         delete [] tlb;
 }
 
+//----------------------------------------------------------------------
+// Machine::StartFastForward
+// 	Run user programs functionally, as fast as we can, to skip over
+//	a phase (typically start-up) whose timing is not of interest.
+//	User instructions still take UserTick each, so that interrupts
+//	happen and threads are switched as before, but the caches, the 
+//	profiler, the tracer, the cost model and the 'm' debug trace are
+//	set aside, the
+//	fastest engine runs, and the disk takes one tick a request.
+//
+//	"instructions" -- switch to detailed timing once this many user
+//		instructions have run (checked at the end of each basic
+//		block), or 0 to wait for StartTiming
+//----------------------------------------------------------------------
+
+void
+Machine::StartFastForward(int instructions)
+{
+    fastForwardEnd = (instructions > 0) ? instructions : NeverDue;
+    savedProfiler = profiler;
+    savedTracer = tracer;
+    savedCostModel = costModel;
+    savedCaches[0] = icache;
+    savedCaches[1] = dcache;
+    savedCaches[2] = l2cache;
+    profiler = NULL;
+    tracer = NULL;
+    costModel = NULL;
+    icache = dcache = l2cache = NULL;
+    interrupt->SetFastForward(TRUE);
+}
+
+//----------------------------------------------------------------------
+// Machine::StartTiming
+// 	Stop fast-forwarding: bring back what StartFastForward set
+//	aside, and note in the statistics how far we skipped.  Called 
+//	when the instruction count is reached, from the StartTiming
+//	system call, or from an interrupt at a given time (-ff).  Does 
+//	nothing if we are not fast-forwarding.
+//----------------------------------------------------------------------
+
+void
+Machine::StartTiming()
+{
+    if (!interrupt->FastForwarding())
+	return;
+    interrupt->SetFastForward(FALSE);
+    profiler = savedProfiler;
+    tracer = savedTracer;
+    costModel = savedCostModel;
+    icache = savedCaches[0];
+    dcache = savedCaches[1];
+    l2cache = savedCaches[2];
+    stats->fastForwardTicks = stats->totalTicks;
+    stats->fastForwardInstructions = stats->userTicks;
+    printf("Fast-forwarded %d user instructions, detailed timing from "
+		"tick %d\n", stats->userTicks, stats->totalTicks);
+}
+
+//----------------------------------------------------------------------
+// Machine::Checkpoint
+// 	Write the user-visible machine state -- registers, main memory,
+//	and the TLB -- to the open file "fd", for Machine::Restore.
+//	Cache and profiler contents are not included.
+//----------------------------------------------------------------------
+
+void
+Machine::Checkpoint(int fd)
+{
+    WriteFile(fd, (char *) registers, sizeof(registers));
+    WriteFile(fd, mainMemory, MemorySize);
+    WriteFile(fd, (char *) &asid, sizeof(asid));
+    if (tlb != NULL)
+	WriteFile(fd, (char *) tlb, TLBSize * sizeof(TranslationEntry));
+}
+
+//----------------------------------------------------------------------
+// Machine::Restore
+// 	Read back the state written by Machine::Checkpoint, into a machine
+//	with the same geometry, and forget everything derived from the
+//	old contents of memory and the TLB.
+//----------------------------------------------------------------------
+
+void
+Machine::Restore(int fd)
+{
+    Read(fd, (char *) registers, sizeof(registers));
+    Read(fd, mainMemory, MemorySize);
+    Read(fd, (char *) &asid, sizeof(asid));
+    if (tlb != NULL)
+	Read(fd, (char *) tlb, TLBSize * sizeof(TranslationEntry));
+    for (int i = 0; i < NumPhysPages; i++)
+	InvalidateDecodedPage(i);
+    FlushHostTLB();
+    lastEntry = NULL;
+    quietTicks = 0;
+}
+
 //----------------------------------------------------------------------
 // Machine::RaiseException
 // 	Transfer control to the Nachos kernel from user mode, because
@@ -105,10 +259,22 @@ Machine::RaiseException(ExceptionType which, int badVAddr)
     
 //  ASSERT(interrupt->getStatus() == UserMode);
     registers[BadVAddrReg] = badVAddr;
+    MachineStatus oldStatus = interrupt->getStatus(); // SystemMode if the
+					// kernel faulted, in ReadMem or WriteMem
+    if ((which != SyscallException) && (oldStatus == UserMode))
+	stats->numUserInstructions--;	// it is charged a tick, but will be
+					// restarted or never complete (the
+					// kernel's own faults were never 
+					// charged)
     DelayedLoad(0, 0);			// finish anything in progress
+    if (costModel != NULL)
+	costModel->Flush();
     interrupt->setStatus(SystemMode);
     ExceptionHandler(which);		// interrupts are enabled at this point
-    interrupt->setStatus(UserMode);
+    interrupt->setStatus(oldStatus);	// back to the user program, or to
+					// the handler that faulted
+    quietTicks = 0;			// the handler may have scheduled an
+					// interrupt, or run another thread
 }
 
 //----------------------------------------------------------------------
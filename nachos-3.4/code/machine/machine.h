@@ -26,15 +26,28 @@
 #include "translate.h"
 #include "disk.h"
 
-// Definitions related to the size, and format of user memory
+// Definitions related to the size, and format of user memory.
+// The geometry of the machine can be chosen when Nachos starts up
+// (see Initialize in system.cc); these are the defaults.
 
-#define PageSize 	SectorSize 	// set the page size equal to
+#define DefaultPageSize 	SectorSize 	// set the page size equal to
 					// the disk sector size, for
 					// simplicity
 
-#define NumPhysPages    32
+#define DefaultNumPhysPages	32
+#define DefaultTLBSize		4	// if there is a TLB, make it small
+#define DefaultTLBWays		0	// 0 = fully associative
+
+extern int pageSize;		// bytes per page, a multiple of 4
+extern int numPhysPages;	// pages of physical memory
+extern int tlbSize;		// entries in the TLB
+extern int tlbWays;		// entries in each set of the TLB
+
+#define PageSize 	pageSize
+#define NumPhysPages    numPhysPages
 #define MemorySize 	(NumPhysPages * PageSize)
-#define TLBSize		4		// if there is a TLB, make it small
+#define TLBSize		tlbSize
+#define TLBWays		tlbWays
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -91,6 +104,53 @@ class Instruction {
                      // Immediates are sign-extended.
 };
 
+// The simulator can execute user code with either of two engines, chosen
+// when the machine is created.  Both give exactly the same results.
+
+enum ExecEngine { InterpEngine,		// reference interpreter: decode and
+					// switch on every instruction
+		  BlockEngine,		// threaded dispatch, a basic block
+					// at a time
+		  JitEngine };		// hot blocks translated to MicroOps
+					// (see jit.h)
+
+class BlockTranslator;
+class Profiler;
+class Cache;
+class TraceRecorder;
+class CostModel;
+
+// With a TLB, the machine can optionally refill it in hardware, by
+// walking a two-level page table set up by the kernel: "pageDirectory"
+// has WalkDirSize pointers, each NULL or pointing to WalkTableSize
+// TranslationEntries, so that virtual page "vpn" is described by
+// pageDirectory[vpn / WalkTableSize][vpn % WalkTableSize].  Only a
+// page that is not valid there traps to the kernel.
+
+#define WalkTableSize	64	// entries in a second-level table
+#define WalkDirSize	1024	// entries in the page directory
+
+// The following class defines an entry in the host TLB -- a small,
+// direct-mapped cache that lets ReadMem and WriteMem go from a virtual
+// page straight to a host pointer into mainMemory, without searching the
+// simulated TLB or page table.  It only caches translations that
+// Translate() has already checked, and a hit still updates the use, dirty
+// and hit fields of the TranslationEntry it came from.
+//
+// The kernel must call Machine::FlushHostTLB() whenever it changes an
+// entry of the TLB or page table that may have been used; switching to
+// a different page table is noticed automatically.
+
+#define HostTLBSize	64	// must be a power of 2
+
+class HostTLBEntry {
+  public:
+    int virtualPage;		// -1 if this entry is empty
+    TranslationEntry *entry;	// the translation it was filled from
+    char *page;			// host address of the physical page
+    bool writable;		// FALSE if the page is read-only
+};
+
 // The following class defines the simulated host workstation hardware, as 
 // seen by user programs -- the CPU registers, main memory, etc.
 // User programs shouldn't be able to tell that they are running on our 
@@ -101,12 +161,13 @@ class Instruction {
 // If we were to implement more of the UNIX system calls, we ought to be
 // able to run Nachos on top of Nachos!
 //
-// The procedures in this class are defined in machine.cc, mipssim.cc, and
-// translate.cc.
+// The procedures in this class are defined in machine.cc, mipssim.cc,
+// jit.cc and translate.cc.
 
 class Machine {
   public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
+    Machine(bool debug, ExecEngine whichEngine = InterpEngine);
+				// Initialize the simulation of the hardware
 				// for running user programs
     ~Machine();			// De-allocate the data structures
 
@@ -121,8 +182,25 @@ class Machine {
 
 // Routines internal to the machine simulation -- DO NOT call these 
 
-    void OneInstruction(Instruction *instr); 	
-    				// Run one instruction of a user program.
+    void OneInstruction(); 	// Run one instruction of a user program.
+    bool ExecuteInstruction(Instruction *instr);
+				// Execute a decoded instruction; return
+				// FALSE if it raised an exception
+    void RunBlock();		// Run the rest of a basic block of a
+				// user program, with threaded dispatch
+    void RunTranslated();	// Run a block of a user program, from 
+				// its translation if it is hot
+    Instruction *FetchInstruction();
+				// Translate the PC and return the
+				// pre-decoded instruction stored there, or
+				// NULL if the fetch raised an exception
+    void InvalidateDecodedPage(int physPage);
+				// Forget the pre-decoded copy of a physical
+				// page, because its contents changed
+    void FlushHostTLB();		// Forget all cached host translations
+    void ChargeTick();		// Advance simulated time by one user
+				// instruction
+    void Stall(int ticks);	// Advance simulated time by a cache miss
     void DelayedLoad(int nextReg, int nextVal);  	
 				// Do a pending delayed load (modifying a reg)
     
@@ -139,6 +217,14 @@ class Machine {
     				// and return an exception code if the 
 				// translation couldn't be completed.
 
+    TranslationEntry *TLBVictim(int vpn);
+				// The TLB entry to replace to make room
+				// for "vpn" of the running address space
+    int TLBSet(int vpn, int space);
+				// Index of the first TLB entry of the set
+				// that may hold "vpn" of address space
+				// "space"; the set is TLBWays entries long.
+
     void RaiseException(ExceptionType which, int badVAddr);
 				// Trap to the Nachos kernel, because of a
 				// system call or other exception.  
@@ -146,6 +232,14 @@ class Machine {
     void Debugger();		// invoke the user program debugger
     void DumpState();		// print the user CPU and memory state 
 
+    void StartFastForward(int instructions);
+				// Run user programs with no timing detail
+				// for "instructions" (0: until StartTiming)
+    void StartTiming();		// Back to the full timing simulation
+
+    void Checkpoint(int fd);	// save registers, memory and TLB to a file
+    void Restore(int fd);	// and load them back
+
 
 // Data structures -- all of these are accessible to Nachos kernel code.
 // "public" for convenience.
@@ -182,11 +276,62 @@ class Machine {
     TranslationEntry *pageTable;
     unsigned int pageTableSize;
 
+    TranslationEntry **pageDirectory;	// if non-NULL (and there is a
+				// TLB), TLB misses are refilled from 
+				// this page table, without a trap
+
+    Profiler *profiler;		// counts where user programs spend their
+				// time; NULL unless profiling (-prof)
+
+    Cache *icache;		// timing models of the L1 instruction and
+    Cache *dcache;		// data caches, and the L2 cache behind
+    Cache *l2cache;		// them; NULL if not simulated (-l1, -l2)
+
+    TraceRecorder *tracer;	// records every instruction executed;
+				// NULL unless tracing (-trace)
+
+    CostModel *costModel;	// ticks each instruction by its class;
+				// NULL to charge UserTick for all (-cost)
+
+    int asid;			// address space identifier of the running
+				// process.  A TLB entry only matches if its
+				// "asid" is the same, so the kernel can 
+				// leave the entries of other processes in 
+				// the TLB instead of flushing it.
+
   private:
+    Instruction *decodedMemory;	// pre-decoded copy of mainMemory, one
+				// Instruction per word
+    bool *pageDecoded;		// TRUE if the words of a physical page
+				// in decodedMemory are up to date
+    void DecodePage(int physPage);	// refill decodedMemory for a page
+
+    ExecEngine engine;		// how Run() executes user instructions
+    BlockTranslator *translator;	// hot blocks, if engine is JitEngine
+    TranslationEntry *lastEntry;	// entry used by the last successful
+					// Translate()
+    HostTLBEntry hostTLB[HostTLBSize];	// host pointers for recently
+					// translated pages
+    bool hostTLBEnabled;	// FALSE when tracing address translation
+    TranslationEntry *hostTLBPageTable;	// page table the host TLB was
+					// filled from
+    TranslationEntry *WalkPageTable(int vpn);
+				// refill the TLB from pageDirectory
+    char *HostAddress(int virtAddr, int size, bool writing);
+				// host pointer for an access, if the
+				// host TLB has it, else NULL
+    int quietTicks;		// user instructions that can still be
+				// charged without calling OneTick
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
 				// time reaches this value
+
+    int fastForwardEnd;		// userTicks at which to StartTiming
+    Profiler *savedProfiler;	// set aside while fast-forwarding
+    TraceRecorder *savedTracer;
+    CostModel *savedCostModel;
+    Cache *savedCaches[3];	// icache, dcache, l2cache
 };
 
 extern void ExceptionHandler(ExceptionType which);
@@ -14,6 +14,11 @@
 
 #include "machine.h"
 #include "mipssim.h"
+#include "jit.h"
+#include "profile.h"
+#include "cache.h"
+#include "trace.h"
+#include "costmodel.h"
 #include "system.h"
 
 static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
@@ -23,6 +28,16 @@ static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
 // 	Simulate the execution of a user-level program on Nachos.
 //	Called by the kernel when the program starts up; never returns.
 //
+//	The basic-block and JIT engines are only used when nobody needs to see
+//	individual instructions: single-stepping, the 'm' debug trace,
+//	the profiler, the tracer and the cost model always go through the
+//	reference interpreter.  The JIT
+//	does not fetch every instruction, so it is not used with caches.
+//
+//	While fast-forwarding (see StartFastForward), none of that 
+//	applies: the fastest engine runs, and the caches and the rest are
+//	set aside, until the switch to detailed timing.
+//
 //	This routine is re-entrant, in that it can be called multiple
 //	times concurrently -- one for each thread executing user code.
 //----------------------------------------------------------------------
@@ -30,21 +45,102 @@ static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
 void
 Machine::Run()
 {
-    Instruction *instr = new Instruction;  // storage for decoded instruction
+    bool watched;
 
     if(DebugIsEnabled('m'))
         printf("Starting thread \"%s\" at time %d\n",
 	       currentThread->getName(), stats->totalTicks);
     interrupt->setStatus(UserMode);
+    quietTicks = 0;
+    while (interrupt->FastForwarding()) {	// another thread, or an
+	if (stats->userTicks >= fastForwardEnd) { // interrupt, may end it
+	    StartTiming();
+	    break;
+	}
+	if (translator != NULL)
+	    RunTranslated();
+	else
+	    RunBlock();
+    }
+
+    watched = singleStep || DebugIsEnabled('m') || (profiler != NULL)
+			|| (tracer != NULL) || (costModel != NULL);
+    if ((engine == BlockEngine) && !watched) {
+	for (;;)
+	    RunBlock();
+    }
+    if ((engine == JitEngine) && !watched && (icache == NULL)) {
+	for (;;)
+	    RunTranslated();
+    }
     for (;;) {
-        OneInstruction(instr);
-	interrupt->OneTick();
+        OneInstruction();
+	ChargeTick();
 	if (singleStep && (runUntilTime <= stats->totalTicks))
 	  Debugger();
     }
 }
 
 
+//----------------------------------------------------------------------
+// Machine::ChargeTick
+// 	Advance simulated time by one user instruction.
+//
+//	Calling interrupt->OneTick() after every instruction is expensive,
+//	and almost always all it does is advance the clock, so instead we
+//	ask the interrupt simulation when it next has something to do,
+//	and until then charge UserTick ourselves.  The ticks in between
+//	are exactly those on which OneTick would have found nothing due, 
+//	so the results are cycle-identical.
+//
+//	Anything that may schedule an interrupt or switch threads -- an
+//	exception, or OneTick itself -- ends the batch (see 
+//	RaiseException).
+//----------------------------------------------------------------------
+
+void
+Machine::ChargeTick()
+{
+    stats->numUserInstructions++;	// see RaiseException
+    if (quietTicks > 0) {
+	quietTicks--;
+	stats->totalTicks += UserTick;
+	stats->userTicks += UserTick;
+	return;
+    }
+    if (costModel != NULL)		// an interrupt may run another thread
+	costModel->Flush();
+    interrupt->OneTick();
+    quietTicks = (interrupt->NextDueTime() - stats->totalTicks - 1) / UserTick;
+    if (quietTicks < 0)
+	quietTicks = 0;
+}
+
+//----------------------------------------------------------------------
+// Machine::Stall
+// 	Advance simulated time by "ticks", because a memory access 
+//	missed in the caches.  Kernel accesses to user memory (from
+//	system calls) are charged to the kernel.
+//
+//	The time is charged directly, so we must take it out of the
+//	ticks ChargeTick can still batch before the next interrupt.
+//----------------------------------------------------------------------
+
+void
+Machine::Stall(int ticks)
+{
+    if (ticks == 0)
+	return;
+    stats->totalTicks += ticks;
+    if (interrupt->getStatus() == UserMode)
+	stats->userTicks += ticks;
+    else
+	stats->systemTicks += ticks;
+    quietTicks -= divRoundUp(ticks, UserTick);
+    if (quietTicks < 0)
+	quietTicks = 0;
+}
+
 //----------------------------------------------------------------------
 // TypeToReg
 // 	Retrieve the register # referred to in an instruction. 
@@ -91,18 +187,14 @@ TypeToReg(RegType reg, Instruction *instr)
 //----------------------------------------------------------------------
 
 void
-Machine::OneInstruction(Instruction *instr)
+Machine::OneInstruction()
 {
-    int raw;
-    int nextLoadReg = 0; 	
-    int nextLoadValue = 0; 	// record delayed load operation, to apply
-				// in the future
+    Instruction *instr;
 
     // Fetch instruction 
-    if (!machine->ReadMem(registers[PCReg], 4, &raw))
+    instr = FetchInstruction();
+    if (instr == NULL)
 	return;			// exception occurred
-    instr->value = raw;
-    instr->Decode();
 
     if (DebugIsEnabled('m')) {
        struct OpString *str = &opStrings[instr->opCode];
@@ -113,7 +205,45 @@ Machine::OneInstruction(Instruction *instr)
 		TypeToReg(str->args[1], instr), TypeToReg(str->args[2], instr));
        printf("\n");
        }
+    if (profiler != NULL)		// counts restarts after a fault, too
+	profiler->CountInstruction(registers[PCReg], registers[PrevPCReg]);
+    if ((tracer != NULL) || (costModel != NULL)) {
+	int pc = registers[PCReg];
+	int memAddr = registers[instr->rs] + instr->extra;  // before a load
+							    // changes rs
+	if ((costModel != NULL) && (instr->opCode == OP_SYSCALL))
+	    Stall(costModel->Charge(instr, pc, pc + 8)); // it always traps,
+							 // so charge it first
+	if (!ExecuteInstruction(instr))
+	    return;
+	if (tracer != NULL)
+	    tracer->Record(pc, instr->opCode, memAddr);
+	if (costModel != NULL)		// UserTick is charged by our caller
+	    Stall(costModel->Charge(instr, pc, registers[NextPCReg]));
+	return;
+    }
     
+    (void) ExecuteInstruction(instr);
+}
+
+//----------------------------------------------------------------------
+// Machine::ExecuteInstruction
+// 	Execute an already fetched and decoded instruction, and advance
+//	the program counters past it.
+//
+//	Returns FALSE if the instruction raised an exception (which has
+//	been handled by the time we return), TRUE otherwise.
+//
+//	"instr" -- the decoded instruction at registers[PCReg]
+//----------------------------------------------------------------------
+
+bool
+Machine::ExecuteInstruction(Instruction *instr)
+{
+    int nextLoadReg = 0; 	
+    int nextLoadValue = 0; 	// record delayed load operation, to apply
+				// in the future
+
     // Compute next pc, but don't install in case there's an error or branch.
     int pcAfter = registers[NextPCReg] + 4;
     int sum, diff, tmp, value;
@@ -122,431 +252,13 @@ Machine::OneInstruction(Instruction *instr)
     // Execute the instruction (cf. Kane's book)
     switch (instr->opCode) {
 	
-      case OP_ADD:
-	sum = registers[instr->rs] + registers[instr->rt];
-	if (!((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT) &&
-	    ((registers[instr->rs] ^ sum) & SIGN_BIT)) {
-	    RaiseException(OverflowException, 0);
-	    return;
-	}
-	registers[instr->rd] = sum;
-	break;
-	
-      case OP_ADDI:
-	sum = registers[instr->rs] + instr->extra;
-	if (!((registers[instr->rs] ^ instr->extra) & SIGN_BIT) &&
-	    ((instr->extra ^ sum) & SIGN_BIT)) {
-	    RaiseException(OverflowException, 0);
-	    return;
-	}
-	registers[instr->rt] = sum;
-	break;
-	
-      case OP_ADDIU:
-	registers[instr->rt] = registers[instr->rs] + instr->extra;
-	break;
-	
-      case OP_ADDU:
-	registers[instr->rd] = registers[instr->rs] + registers[instr->rt];
-	break;
-	
-      case OP_AND:
-	registers[instr->rd] = registers[instr->rs] & registers[instr->rt];
-	break;
-	
-      case OP_ANDI:
-	registers[instr->rt] = registers[instr->rs] & (instr->extra & 0xffff);
-	break;
-	
-      case OP_BEQ:
-	if (registers[instr->rs] == registers[instr->rt])
-	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
-	
-      case OP_BGEZAL:
-	registers[R31] = registers[NextPCReg] + 4;
-      case OP_BGEZ:
-	if (!(registers[instr->rs] & SIGN_BIT))
-	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
-	
-      case OP_BGTZ:
-	if (registers[instr->rs] > 0)
-	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
-	
-      case OP_BLEZ:
-	if (registers[instr->rs] <= 0)
-	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
-	
-      case OP_BLTZAL:
-	registers[R31] = registers[NextPCReg] + 4;
-      case OP_BLTZ:
-	if (registers[instr->rs] & SIGN_BIT)
-	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
-	
-      case OP_BNE:
-	if (registers[instr->rs] != registers[instr->rt])
-	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
-	
-      case OP_DIV:
-	if (registers[instr->rt] == 0) {
-	    registers[LoReg] = 0;
-	    registers[HiReg] = 0;
-	} else {
-	    registers[LoReg] =  registers[instr->rs] / registers[instr->rt];
-	    registers[HiReg] = registers[instr->rs] % registers[instr->rt];
-	}
-	break;
-	
-      case OP_DIVU:	  
-	  rs = (unsigned int) registers[instr->rs];
-	  rt = (unsigned int) registers[instr->rt];
-	  if (rt == 0) {
-	      registers[LoReg] = 0;
-	      registers[HiReg] = 0;
-	  } else {
-	      tmp = rs / rt;
-	      registers[LoReg] = (int) tmp;
-	      tmp = rs % rt;
-	      registers[HiReg] = (int) tmp;
-	  }
-	  break;
-	
-      case OP_JAL:
-	registers[R31] = registers[NextPCReg] + 4;
-      case OP_J:
-	pcAfter = (pcAfter & 0xf0000000) | IndexToAddr(instr->extra);
-	break;
-	
-      case OP_JALR:
-	registers[instr->rd] = registers[NextPCReg] + 4;
-      case OP_JR:
-	pcAfter = registers[instr->rs];
-	break;
-	
-      case OP_LB:
-      case OP_LBU:
-	tmp = registers[instr->rs] + instr->extra;
-	if (!machine->ReadMem(tmp, 1, &value))
-	    return;
-
-	if ((value & 0x80) && (instr->opCode == OP_LB))
-	    value |= 0xffffff00;
-	else
-	    value &= 0xff;
-	nextLoadReg = instr->rt;
-	nextLoadValue = value;
-	break;
-	
-      case OP_LH:
-      case OP_LHU:	  
-	tmp = registers[instr->rs] + instr->extra;
-	if (tmp & 0x1) {
-	    RaiseException(AddressErrorException, tmp);
-	    return;
-	}
-	if (!machine->ReadMem(tmp, 2, &value))
-	    return;
-
-	if ((value & 0x8000) && (instr->opCode == OP_LH))
-	    value |= 0xffff0000;
-	else
-	    value &= 0xffff;
-	nextLoadReg = instr->rt;
-	nextLoadValue = value;
-	break;
-      	
-      case OP_LUI:
-	DEBUG('m', "Executing: LUI r%d,%d\n", instr->rt, instr->extra);
-	registers[instr->rt] = instr->extra << 16;
-	break;
-	
-      case OP_LW:
-	tmp = registers[instr->rs] + instr->extra;
-	if (tmp & 0x3) {
-	    RaiseException(AddressErrorException, tmp);
-	    return;
-	}
-	if (!machine->ReadMem(tmp, 4, &value))
-	    return;
-	nextLoadReg = instr->rt;
-	nextLoadValue = value;
-	break;
-    	
-      case OP_LWL:	  
-	tmp = registers[instr->rs] + instr->extra;
-
-	// ReadMem assumes all 4 byte requests are aligned on an even 
-	// word boundary.  Also, the little endian/big endian swap code would
-        // fail (I think) if the other cases are ever exercised.
-	ASSERT((tmp & 0x3) == 0);  
-
-	if (!machine->ReadMem(tmp, 4, &value))
-	    return;
-	if (registers[LoadReg] == instr->rt)
-	    nextLoadValue = registers[LoadValueReg];
-	else
-	    nextLoadValue = registers[instr->rt];
-	switch (tmp & 0x3) {
-	  case 0:
-	    nextLoadValue = value;
-	    break;
-	  case 1:
-	    nextLoadValue = (nextLoadValue & 0xff) | (value << 8);
-	    break;
-	  case 2:
-	    nextLoadValue = (nextLoadValue & 0xffff) | (value << 16);
-	    break;
-	  case 3:
-	    nextLoadValue = (nextLoadValue & 0xffffff) | (value << 24);
-	    break;
-	}
-	nextLoadReg = instr->rt;
-	break;
-      	
-      case OP_LWR:
-	tmp = registers[instr->rs] + instr->extra;
-
-	// ReadMem assumes all 4 byte requests are aligned on an even 
-	// word boundary.  Also, the little endian/big endian swap code would
-        // fail (I think) if the other cases are ever exercised.
-	ASSERT((tmp & 0x3) == 0);  
-
-	if (!machine->ReadMem(tmp, 4, &value))
-	    return;
-	if (registers[LoadReg] == instr->rt)
-	    nextLoadValue = registers[LoadValueReg];
-	else
-	    nextLoadValue = registers[instr->rt];
-	switch (tmp & 0x3) {
-	  case 0:
-	    nextLoadValue = (nextLoadValue & 0xffffff00) |
-		((value >> 24) & 0xff);
-	    break;
-	  case 1:
-	    nextLoadValue = (nextLoadValue & 0xffff0000) |
-		((value >> 16) & 0xffff);
-	    break;
-	  case 2:
-	    nextLoadValue = (nextLoadValue & 0xff000000)
-		| ((value >> 8) & 0xffffff);
-	    break;
-	  case 3:
-	    nextLoadValue = value;
-	    break;
-	}
-	nextLoadReg = instr->rt;
-	break;
-    	
-      case OP_MFHI:
-	registers[instr->rd] = registers[HiReg];
-	break;
-	
-      case OP_MFLO:
-	registers[instr->rd] = registers[LoReg];
-	break;
-	
-      case OP_MTHI:
-	registers[HiReg] = registers[instr->rs];
-	break;
-	
-      case OP_MTLO:
-	registers[LoReg] = registers[instr->rs];
-	break;
-	
-      case OP_MULT:
-	Mult(registers[instr->rs], registers[instr->rt], TRUE,
-	     &registers[HiReg], &registers[LoReg]);
-	break;
-	
-      case OP_MULTU:
-	Mult(registers[instr->rs], registers[instr->rt], FALSE,
-	     &registers[HiReg], &registers[LoReg]);
-	break;
-	
-      case OP_NOR:
-	registers[instr->rd] = ~(registers[instr->rs] | registers[instr->rt]);
-	break;
-	
-      case OP_OR:
-	registers[instr->rd] = registers[instr->rs] | registers[instr->rs];
-	break;
-	
-      case OP_ORI:
-	registers[instr->rt] = registers[instr->rs] | (instr->extra & 0xffff);
-	break;
-	
-      case OP_SB:
-	if (!machine->WriteMem((unsigned) 
-		(registers[instr->rs] + instr->extra), 1, registers[instr->rt]))
-	    return;
-	break;
-	
-      case OP_SH:
-	if (!machine->WriteMem((unsigned) 
-		(registers[instr->rs] + instr->extra), 2, registers[instr->rt]))
-	    return;
-	break;
-	
-      case OP_SLL:
-	registers[instr->rd] = registers[instr->rt] << instr->extra;
-	break;
-	
-      case OP_SLLV:
-	registers[instr->rd] = registers[instr->rt] <<
-	    (registers[instr->rs] & 0x1f);
-	break;
-	
-      case OP_SLT:
-	if (registers[instr->rs] < registers[instr->rt])
-	    registers[instr->rd] = 1;
-	else
-	    registers[instr->rd] = 0;
-	break;
-	
-      case OP_SLTI:
-	if (registers[instr->rs] < instr->extra)
-	    registers[instr->rt] = 1;
-	else
-	    registers[instr->rt] = 0;
-	break;
-	
-      case OP_SLTIU:	  
-	rs = registers[instr->rs];
-	imm = instr->extra;
-	if (rs < imm)
-	    registers[instr->rt] = 1;
-	else
-	    registers[instr->rt] = 0;
-	break;
-      	
-      case OP_SLTU:	  
-	rs = registers[instr->rs];
-	rt = registers[instr->rt];
-	if (rs < rt)
-	    registers[instr->rd] = 1;
-	else
-	    registers[instr->rd] = 0;
-	break;
-      	
-      case OP_SRA:
-	registers[instr->rd] = registers[instr->rt] >> instr->extra;
-	break;
-	
-      case OP_SRAV:
-	registers[instr->rd] = registers[instr->rt] >>
-	    (registers[instr->rs] & 0x1f);
-	break;
-	
-      case OP_SRL:
-	tmp = registers[instr->rt];
-	tmp >>= instr->extra;
-	registers[instr->rd] = tmp;
-	break;
-	
-      case OP_SRLV:
-	tmp = registers[instr->rt];
-	tmp >>= (registers[instr->rs] & 0x1f);
-	registers[instr->rd] = tmp;
-	break;
-	
-      case OP_SUB:	  
-	diff = registers[instr->rs] - registers[instr->rt];
-	if (((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT) &&
-	    ((registers[instr->rs] ^ diff) & SIGN_BIT)) {
-	    RaiseException(OverflowException, 0);
-	    return;
-	}
-	registers[instr->rd] = diff;
-	break;
-      	
-      case OP_SUBU:
-	registers[instr->rd] = registers[instr->rs] - registers[instr->rt];
-	break;
-	
-      case OP_SW:
-	if (!machine->WriteMem((unsigned) 
-		(registers[instr->rs] + instr->extra), 4, registers[instr->rt]))
-	    return;
-	break;
-	
-      case OP_SWL:	  
-	tmp = registers[instr->rs] + instr->extra;
-
-	// The little endian/big endian swap code would
-        // fail (I think) if the other cases are ever exercised.
-	ASSERT((tmp & 0x3) == 0);  
-
-	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
-	    return;
-	switch (tmp & 0x3) {
-	  case 0:
-	    value = registers[instr->rt];
-	    break;
-	  case 1:
-	    value = (value & 0xff000000) | ((registers[instr->rt] >> 8) &
-					    0xffffff);
-	    break;
-	  case 2:
-	    value = (value & 0xffff0000) | ((registers[instr->rt] >> 16) &
-					    0xffff);
-	    break;
-	  case 3:
-	    value = (value & 0xffffff00) | ((registers[instr->rt] >> 24) &
-					    0xff);
-	    break;
-	}
-	if (!machine->WriteMem((tmp & ~0x3), 4, value))
-	    return;
-	break;
-    	
-      case OP_SWR:	  
-	tmp = registers[instr->rs] + instr->extra;
-
-	// The little endian/big endian swap code would
-        // fail (I think) if the other cases are ever exercised.
-	ASSERT((tmp & 0x3) == 0);  
-
-	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
-	    return;
-	switch (tmp & 0x3) {
-	  case 0:
-	    value = (value & 0xffffff) | (registers[instr->rt] << 24);
-	    break;
-	  case 1:
-	    value = (value & 0xffff) | (registers[instr->rt] << 16);
-	    break;
-	  case 2:
-	    value = (value & 0xff) | (registers[instr->rt] << 8);
-	    break;
-	  case 3:
-	    value = registers[instr->rt];
-	    break;
-	}
-	if (!machine->WriteMem((tmp & ~0x3), 4, value))
-	    return;
-	break;
-    	
-      case OP_SYSCALL:
-	RaiseException(SyscallException, 0);
-	return; 
-	
-      case OP_XOR:
-	registers[instr->rd] = registers[instr->rs] ^ registers[instr->rt];
-	break;
-	
-      case OP_XORI:
-	registers[instr->rt] = registers[instr->rs] ^ (instr->extra & 0xffff);
-	break;
-	
-      case OP_RES:
-      case OP_UNIMP:
-	RaiseException(IllegalInstrException, 0);
-	return;
+#define OPCASE(op)	case op
+#define OPNEXT		break
+#define OPFAULT		return FALSE
+#include "mipsexec.h"
+#undef OPCASE
+#undef OPNEXT
+#undef OPFAULT
 	
       default:
 	ASSERT(FALSE);
@@ -562,6 +274,205 @@ Machine::OneInstruction(Instruction *instr)
 						// are jumping into lala-land
     registers[PCReg] = registers[NextPCReg];
     registers[NextPCReg] = pcAfter;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::RunBlock
+// 	Execute user instructions up to the end of the current basic
+//	block -- that is, until control has been transferred somewhere
+//	other than the next sequential instruction (after the branch
+//	delay slot has executed), or an exception has been raised.
+//
+//	The instruction semantics are the same as in ExecuteInstruction
+//	(both include mipsexec.h), but each instruction is dispatched 
+//	through a table of computed-goto labels indexed by opCode, 
+//	and we stay in this routine for the whole block.  Simulated 
+//	time still advances by one tick per instruction, and 
+//	delayed loads and delay slots are handled exactly as by the 
+//	reference interpreter, so the results are identical.
+//----------------------------------------------------------------------
+
+void
+Machine::RunBlock()
+{
+    static void *dispatch[MaxOpcode + 1];	// handler for each opCode
+    static bool dispatchReady = FALSE;
+    Instruction *instr;
+    int nextLoadReg, nextLoadValue, pcAfter;
+    int sum, diff, tmp, value;
+    unsigned int rs, rt, imm;
+
+    if (!dispatchReady) {
+	for (int i = 0; i <= MaxOpcode; i++)
+	    dispatch[i] = &&L_bad;
+	dispatch[OP_ADD] = &&L_OP_ADD;
+	dispatch[OP_ADDI] = &&L_OP_ADDI;
+	dispatch[OP_ADDIU] = &&L_OP_ADDIU;
+	dispatch[OP_ADDU] = &&L_OP_ADDU;
+	dispatch[OP_AND] = &&L_OP_AND;
+	dispatch[OP_ANDI] = &&L_OP_ANDI;
+	dispatch[OP_BEQ] = &&L_OP_BEQ;
+	dispatch[OP_BGEZAL] = &&L_OP_BGEZAL;
+	dispatch[OP_BGEZ] = &&L_OP_BGEZ;
+	dispatch[OP_BGTZ] = &&L_OP_BGTZ;
+	dispatch[OP_BLEZ] = &&L_OP_BLEZ;
+	dispatch[OP_BLTZAL] = &&L_OP_BLTZAL;
+	dispatch[OP_BLTZ] = &&L_OP_BLTZ;
+	dispatch[OP_BNE] = &&L_OP_BNE;
+	dispatch[OP_DIV] = &&L_OP_DIV;
+	dispatch[OP_DIVU] = &&L_OP_DIVU;
+	dispatch[OP_JAL] = &&L_OP_JAL;
+	dispatch[OP_J] = &&L_OP_J;
+	dispatch[OP_JALR] = &&L_OP_JALR;
+	dispatch[OP_JR] = &&L_OP_JR;
+	dispatch[OP_LB] = &&L_OP_LB;
+	dispatch[OP_LBU] = &&L_OP_LBU;
+	dispatch[OP_LH] = &&L_OP_LH;
+	dispatch[OP_LHU] = &&L_OP_LHU;
+	dispatch[OP_LUI] = &&L_OP_LUI;
+	dispatch[OP_LW] = &&L_OP_LW;
+	dispatch[OP_LWL] = &&L_OP_LWL;
+	dispatch[OP_LWR] = &&L_OP_LWR;
+	dispatch[OP_MFHI] = &&L_OP_MFHI;
+	dispatch[OP_MFLO] = &&L_OP_MFLO;
+	dispatch[OP_MTHI] = &&L_OP_MTHI;
+	dispatch[OP_MTLO] = &&L_OP_MTLO;
+	dispatch[OP_MULT] = &&L_OP_MULT;
+	dispatch[OP_MULTU] = &&L_OP_MULTU;
+	dispatch[OP_NOR] = &&L_OP_NOR;
+	dispatch[OP_OR] = &&L_OP_OR;
+	dispatch[OP_ORI] = &&L_OP_ORI;
+	dispatch[OP_SB] = &&L_OP_SB;
+	dispatch[OP_SH] = &&L_OP_SH;
+	dispatch[OP_SLL] = &&L_OP_SLL;
+	dispatch[OP_SLLV] = &&L_OP_SLLV;
+	dispatch[OP_SLT] = &&L_OP_SLT;
+	dispatch[OP_SLTI] = &&L_OP_SLTI;
+	dispatch[OP_SLTIU] = &&L_OP_SLTIU;
+	dispatch[OP_SLTU] = &&L_OP_SLTU;
+	dispatch[OP_SRA] = &&L_OP_SRA;
+	dispatch[OP_SRAV] = &&L_OP_SRAV;
+	dispatch[OP_SRL] = &&L_OP_SRL;
+	dispatch[OP_SRLV] = &&L_OP_SRLV;
+	dispatch[OP_SUB] = &&L_OP_SUB;
+	dispatch[OP_SUBU] = &&L_OP_SUBU;
+	dispatch[OP_SW] = &&L_OP_SW;
+	dispatch[OP_SWL] = &&L_OP_SWL;
+	dispatch[OP_SWR] = &&L_OP_SWR;
+	dispatch[OP_SYSCALL] = &&L_OP_SYSCALL;
+	dispatch[OP_XOR] = &&L_OP_XOR;
+	dispatch[OP_XORI] = &&L_OP_XORI;
+	dispatch[OP_RES] = &&L_OP_RES;
+	dispatch[OP_UNIMP] = &&L_OP_UNIMP;
+	dispatchReady = TRUE;
+    }
+
+    for (;;) {
+	instr = FetchInstruction();
+	if (instr == NULL)
+	    goto faulted;		// exception occurred
+	nextLoadReg = 0;
+	nextLoadValue = 0;
+	pcAfter = registers[NextPCReg] + 4;
+	goto *dispatch[(int) instr->opCode];
+
+#define OPCASE(op)	L_##op
+#define OPNEXT		goto retired
+#define OPFAULT		goto faulted
+#include "mipsexec.h"
+#undef OPCASE
+#undef OPNEXT
+#undef OPFAULT
+
+      L_bad:
+	ASSERT(FALSE);
+
+      retired:
+	DelayedLoad(nextLoadReg, nextLoadValue);
+	registers[PrevPCReg] = registers[PCReg];
+	registers[PCReg] = registers[NextPCReg];
+	registers[NextPCReg] = pcAfter;
+	ChargeTick();
+	if (registers[PCReg] != registers[PrevPCReg] + 4)
+	    return;			// end of the basic block
+    }
+
+  faulted:				// a faulting instruction still
+    ChargeTick();			// takes its tick
+}
+
+//----------------------------------------------------------------------
+// Machine::FetchInstruction
+// 	Translate the current PC and return the decoded instruction there.
+//
+//	Instructions are decoded a physical page at a time, the first time
+//	any word of the page is fetched, and kept in "decodedMemory" until
+//	the page is written to or replaced.  Loops therefore only pay for
+//	Instruction::Decode once per page, instead of once per instruction.
+//
+//	Returns NULL if the translation failed; the exception has already
+//	been raised in that case.
+//----------------------------------------------------------------------
+
+Instruction *
+Machine::FetchInstruction()
+{
+    int physAddr;
+    int page;
+    ExceptionType exception;
+
+    exception = Translate(registers[PCReg], &physAddr, 4, FALSE);
+    if (exception != NoException) {
+	RaiseException(exception, registers[PCReg]);
+	return NULL;
+    }
+    if (icache != NULL)
+	Stall(icache->Access(physAddr));
+    page = physAddr / PageSize;
+    if (!pageDecoded[page])
+	DecodePage(page);
+    return &decodedMemory[physAddr / 4];
+}
+
+//----------------------------------------------------------------------
+// Machine::DecodePage
+// 	Decode every word of a physical page into "decodedMemory".
+//
+//	"physPage" -- the physical page number
+//----------------------------------------------------------------------
+
+void
+Machine::DecodePage(int physPage)
+{
+    int first = physPage * PageSize / 4;
+    int last = first + PageSize / 4;
+
+    DEBUG('m', "Decoding physical page %d\n", physPage);
+    for (int i = first; i < last; i++) {
+	decodedMemory[i].value = 
+		WordToHost(*(unsigned int *) &mainMemory[i * 4]);
+	decodedMemory[i].Decode();
+    }
+    pageDecoded[physPage] = TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::InvalidateDecodedPage
+// 	Called whenever the contents of a physical page change behind the
+//	simulated CPU's back (page loaded, swapped in or out), so that the
+//	next fetch from it decodes the new contents.
+//
+//	"physPage" -- the physical page number
+//----------------------------------------------------------------------
+
+void
+Machine::InvalidateDecodedPage(int physPage)
+{
+    ASSERT((physPage >= 0) && (physPage < NumPhysPages));
+    pageDecoded[physPage] = FALSE;
+    if (translator != NULL)
+	translator->InvalidatePage(physPage);
 }
 
 //----------------------------------------------------------------------
@@ -44,29 +44,27 @@ Network::Network(NetworkAddress addr, double reliability,
     AssignNameToSocket(sockName, sock);		 // Bind socket to a filename 
 						 // in the current directory.
 
-    // start polling for incoming packets
-    interrupt->Schedule(NetworkReadPoll, (int)this, NetworkTime, NetworkRecvInt);
+    // interrupt when a packet arrives
+    interrupt->WatchIO(sock, NetworkReadPoll, (int)this, NetworkTime,
+			NetworkRecvInt);
 }
 
 Network::~Network()
 {
+    interrupt->IgnoreIO(sock);
     CloseSocket(sock);
     DeAssignNameToSocket(sockName);
 }
 
-// if a packet is already buffered, we simply delay reading 
-// the incoming packet.  In real life, the incoming 
-// packet might be dropped if we can't read it in time.
+// called when a packet has arrived on the socket.  The socket is
+// only watched while no packet is buffered, so if one is, we simply
+// delay reading the incoming packet until Receive.  In real life, the
+// incoming packet might be dropped if we can't read it in time.
 void
 Network::CheckPktAvail()
 {
-    // schedule the next time to poll for a packet
-    interrupt->Schedule(NetworkReadPoll, (int)this, NetworkTime, NetworkRecvInt);
-
     if (inHdr.length != 0) 	// do nothing if packet is already buffered
 	return;		
-    if (!PollSocket(sock)) 	// do nothing if no packet to be read
-	return;
 
     // otherwise, read packet in
     char *buffer = new char[MaxWireSize];
@@ -133,6 +131,7 @@ Network::Receive(char* data)
     PacketHeader hdr = inHdr;
 
     inHdr.length = 0;
+    interrupt->ArmIO(sock);	// room for the next packet
     if (hdr.length != 0)
     	bcopy(inbox, data, hdr.length);
     return hdr;
@@ -78,7 +78,8 @@ class Network {
 
     void SendDone();		// Interrupt handler, called when message is 
 				// sent
-    void CheckPktAvail();	// Check if there is an incoming packet
+    void CheckPktAvail();	// Interrupt handler, called when a packet
+				// arrives
 
   private:
     NetworkAddress ident;	// This machine's network address
@@ -0,0 +1,334 @@
+// profile.cc
+//	Routines to count where user programs spend their time, and to
+//	print a hot-spot report when Nachos halts.  See profile.h.
+
+#include "copyright.h"
+#include "profile.h"
+#include "coff.h"
+#include "system.h"
+
+// Comparison routines for SortPointers: most executed first
+
+static int
+CompareExecuted(void *a, void *b)
+{
+    return ((ProfileEntry *) b)->executed - ((ProfileEntry *) a)->executed;
+}
+
+static int
+CompareBlocks(void *a, void *b)
+{
+    return ((ProfileEntry *) b)->blockInstructions
+		- ((ProfileEntry *) a)->blockInstructions;
+}
+
+static int
+CompareMisses(void *a, void *b)
+{
+    ProfileEntry *x = (ProfileEntry *) a, *y = (ProfileEntry *) b;
+
+    return (y->tlbMisses + y->pageFaults) - (x->tlbMisses + x->pageFaults);
+}
+
+static int
+CompareSymbolExecuted(void *a, void *b)
+{
+    return ((ProfileSymbol *) b)->executed - ((ProfileSymbol *) a)->executed;
+}
+
+//----------------------------------------------------------------------
+// SortPointers
+// 	Shell sort an array of "n" pointers, so that compare(a, b) <= 0
+//	for every a before b.
+//----------------------------------------------------------------------
+
+static void
+SortPointers(void **items, int n, int (*compare)(void *, void *))
+{
+    for (int gap = n / 2; gap > 0; gap /= 2)
+	for (int i = gap; i < n; i++) {
+	    void *item = items[i];
+	    int j;
+
+	    for (j = i; (j >= gap) && (compare(items[j - gap], item) > 0); 
+			j -= gap)
+		items[j] = items[j - gap];
+	    items[j] = item;
+	}
+}
+
+//----------------------------------------------------------------------
+// Profiler::Profiler
+// 	Start with no counts, and read the procedure names from the
+//	COFF file the user program was made from.
+//
+//	"coffFile" -- UNIX file name of the program's COFF file, or NULL
+//		to report bare addresses
+//----------------------------------------------------------------------
+
+Profiler::Profiler(char *coffFile)
+{
+    for (int i = 0; i < ProfileBuckets; i++)
+	buckets[i] = NULL;
+    numEntries = 0;
+    currentBlock = NULL;
+    totalExecuted = 0;
+    symbols = NULL;
+    numSymbols = 0;
+    if (coffFile != NULL)
+	ReadSymbols(coffFile);
+}
+
+//----------------------------------------------------------------------
+// Profiler::~Profiler
+// 	Free the counts and the symbols.
+//----------------------------------------------------------------------
+
+Profiler::~Profiler()
+{
+    for (int i = 0; i < ProfileBuckets; i++)
+	while (buckets[i] != NULL) {
+	    ProfileEntry *e = buckets[i];
+
+	    buckets[i] = e->next;
+	    delete e;
+	}
+    for (int i = 0; i < numSymbols; i++)
+	delete [] symbols[i].name;
+    if (symbols != NULL)
+	delete [] symbols;
+}
+
+//----------------------------------------------------------------------
+// Profiler::ReadSymbols
+// 	Read the text procedures from the external symbol table of a
+//	MIPS COFF file, sorted by address.  If the file cannot be read,
+//	the report just gives addresses.
+//----------------------------------------------------------------------
+
+void
+Profiler::ReadSymbols(char *coffFile)
+{
+    struct filehdr fileh;
+    struct symhdr symh;
+    struct extsym sym;
+    char *strings;
+    int fd;
+
+    fd = OpenForReadWrite(coffFile, FALSE);
+    if (fd < 0) {
+	printf("Profiler: unable to open %s, reporting addresses only\n",
+		coffFile);
+	return;
+    }
+    Read(fd, (char *) &fileh, sizeof(fileh));
+    if ((fileh.f_magic != MIPSELMAGIC) || (fileh.f_symptr == 0)) {
+	printf("Profiler: %s has no MIPS COFF symbol table\n", coffFile);
+	Close(fd);
+	return;
+    }
+    Lseek(fd, fileh.f_symptr, 0);
+    Read(fd, (char *) &symh, sizeof(symh));
+
+    strings = new char[symh.issExtMax + 1];
+    Lseek(fd, symh.cbSsExtOffset, 0);
+    Read(fd, strings, symh.issExtMax);
+    strings[symh.issExtMax] = '\0';
+
+    symbols = new ProfileSymbol[symh.iextMax];
+    Lseek(fd, symh.cbExtOffset, 0);
+    for (int i = 0; i < symh.iextMax; i++) {
+	Read(fd, (char *) &sym, sizeof(sym));
+	if ((SymClass(sym.bits) != scText) || (sym.iss < 0) ||
+		(sym.iss >= symh.issExtMax) ||
+		((SymType(sym.bits) != stProc) &&
+		 (SymType(sym.bits) != stStaticProc)))
+	    continue;
+	symbols[numSymbols].address = sym.value;
+	symbols[numSymbols].name = new char[strlen(&strings[sym.iss]) + 1];
+	strcpy(symbols[numSymbols].name, &strings[sym.iss]);
+	symbols[numSymbols].executed = 0;
+	numSymbols++;
+    }
+    for (int i = 1; i < numSymbols; i++) {	// sort by address
+	ProfileSymbol proc = symbols[i];
+	int j;
+
+	for (j = i; (j > 0) && (symbols[j - 1].address > proc.address); j--)
+	    symbols[j] = symbols[j - 1];
+	symbols[j] = proc;
+    }
+    delete [] strings;
+    Close(fd);
+    DEBUG('m', "Profiler: %d procedures in %s\n", numSymbols, coffFile);
+}
+
+//----------------------------------------------------------------------
+// Profiler::Find
+// 	Return the entry for "pc", adding a zeroed one if it is new.
+//----------------------------------------------------------------------
+
+ProfileEntry *
+Profiler::Find(int pc)
+{
+    ProfileEntry **bucket = &buckets[((unsigned) pc / 4) % ProfileBuckets];
+    ProfileEntry *e;
+
+    for (e = *bucket; e != NULL; e = e->next)
+	if (e->pc == pc)
+	    return e;
+    e = new ProfileEntry;
+    e->pc = pc;
+    e->executed = e->blockEntries = e->blockInstructions = 0;
+    e->tlbMisses = e->pageFaults = 0;
+    e->next = *bucket;
+    *bucket = e;
+    numEntries++;
+    return e;
+}
+
+//----------------------------------------------------------------------
+// Profiler::CountInstruction
+// 	Count one execution of the instruction at "pc".  It starts a
+//	new basic block unless it sequentially follows the previously
+//	executed instruction, at "prevPC".
+//----------------------------------------------------------------------
+
+void
+Profiler::CountInstruction(int pc, int prevPC)
+{
+    ProfileEntry *e = Find(pc);
+
+    e->executed++;
+    totalExecuted++;
+    if ((pc != prevPC + 4) || (currentBlock == NULL)) {
+	currentBlock = e;
+	e->blockEntries++;
+    }
+    currentBlock->blockInstructions++;
+}
+
+//----------------------------------------------------------------------
+// Profiler::CountTLBMiss, Profiler::CountPageFault
+// 	Charge a TLB refill, or a fault on a page not in memory, to the
+//	instruction at "pc".
+//----------------------------------------------------------------------
+
+void
+Profiler::CountTLBMiss(int pc)
+{
+    Find(pc)->tlbMisses++;
+}
+
+void
+Profiler::CountPageFault(int pc)
+{
+    Find(pc)->pageFaults++;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Lookup
+// 	Return the procedure containing "pc" -- the one with the highest
+//	address not above it -- or NULL if there is none.
+//----------------------------------------------------------------------
+
+ProfileSymbol *
+Profiler::Lookup(int pc)
+{
+    int lo = 0, hi = numSymbols - 1;
+    ProfileSymbol *found = NULL;
+
+    while (lo <= hi) {
+	int mid = (lo + hi) / 2;
+
+	if (symbols[mid].address <= pc) {
+	    found = &symbols[mid];
+	    lo = mid + 1;
+	} else
+	    hi = mid - 1;
+    }
+    return found;
+}
+
+void
+Profiler::PrintLocation(int pc)
+{
+    ProfileSymbol *s = Lookup(pc);
+
+    if (s == NULL)
+	printf("0x%x", pc);
+    else
+	printf("%s+0x%x", s->name, pc - s->address);
+}
+
+//----------------------------------------------------------------------
+// Profiler::Print
+// 	Print the hot spots: instructions executed per procedure, the
+//	most executed instructions and basic blocks, and the instructions
+//	taking the most TLB misses and page faults.
+//----------------------------------------------------------------------
+
+void
+Profiler::Print()
+{
+    ProfileEntry **all = new ProfileEntry *[numEntries];
+    ProfileSymbol **procs = new ProfileSymbol *[numSymbols];
+    int n = 0, i;
+
+    for (i = 0; i < ProfileBuckets; i++)
+	for (ProfileEntry *e = buckets[i]; e != NULL; e = e->next) {
+	    ProfileSymbol *s = Lookup(e->pc);
+
+	    if (s != NULL)
+		s->executed += e->executed;
+	    all[n++] = e;
+	}
+    if (totalExecuted == 0)
+	totalExecuted = 1;		// avoid dividing by zero below
+
+    printf("\nProfile: %d user instructions at %d distinct PCs\n",
+	totalExecuted, numEntries);
+
+    for (i = 0; i < numSymbols; i++)
+	procs[i] = &symbols[i];
+    SortPointers((void **) procs, numSymbols, CompareSymbolExecuted);
+    printf("\nProcedures:\n%12s %6s  %s\n", "executed", "%", "name");
+    for (i = 0; (i < numSymbols) && (procs[i]->executed > 0); i++)
+	printf("%12d %5.1f%%  %s\n", procs[i]->executed,
+		100.0 * procs[i]->executed / totalExecuted, procs[i]->name);
+
+    SortPointers((void **) all, n, CompareBlocks);
+    printf("\nBasic blocks:\n%12s %12s %6s  %s\n", "executed", "entries",
+		"%", "start");
+    for (i = 0; (i < n) && (i < ProfileTopN) &&
+		(all[i]->blockInstructions > 0); i++) {
+	printf("%12d %12d %5.1f%%  ", all[i]->blockInstructions,
+		all[i]->blockEntries,
+		100.0 * all[i]->blockInstructions / totalExecuted);
+	PrintLocation(all[i]->pc);
+	printf("\n");
+    }
+
+    SortPointers((void **) all, n, CompareExecuted);
+    printf("\nInstructions:\n%12s %6s  %s\n", "executed", "%", "pc");
+    for (i = 0; (i < n) && (i < ProfileTopN); i++) {
+	printf("%12d %5.1f%%  ", all[i]->executed,
+		100.0 * all[i]->executed / totalExecuted);
+	PrintLocation(all[i]->pc);
+	printf("\n");
+    }
+
+    SortPointers((void **) all, n, CompareMisses);
+    printf("\nTLB misses and page faults:\n%12s %12s  %s\n", "tlb misses",
+		"page faults", "pc");
+    for (i = 0; (i < n) && (i < ProfileTopN) &&
+		(all[i]->tlbMisses + all[i]->pageFaults > 0); i++) {
+	printf("%12d %12d  ", all[i]->tlbMisses, all[i]->pageFaults);
+	PrintLocation(all[i]->pc);
+	printf("\n");
+    }
+    printf("\n");
+
+    delete [] all;
+    delete [] procs;
+}
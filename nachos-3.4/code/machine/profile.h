@@ -0,0 +1,74 @@
+// profile.h 
+//	Data structures for profiling user programs: how many times each
+//	instruction (PC) was executed, how many times each basic block 
+//	was entered, and which instructions took TLB misses and page 
+//	faults.  When Nachos halts, the hot spots are printed, with
+//	addresses mapped to procedure names from the program's COFF
+//	symbol table (the NOFF file has no symbols).
+//
+//	Profiling is turned on with -prof; user programs are then always
+//	run by the reference interpreter, one instruction at a time.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define ProfileBuckets	1024	// hash table size, a power of 2
+#define ProfileTopN	20	// entries in each hot-spot list
+
+// What we know about one PC.  Block counts are kept at the PC where
+// the block starts.
+
+class ProfileEntry {
+  public:
+    int pc;			// virtual address of the instruction
+    int executed;		// number of times it was executed
+    int blockEntries;		// number of times a block started here
+    int blockInstructions;	// instructions executed in that block
+    int tlbMisses;		// TLB refills it caused
+    int pageFaults;		// page faults it caused
+    ProfileEntry *next;		// next in the hash bucket
+};
+
+// A procedure from the COFF symbol table.
+
+class ProfileSymbol {
+  public:
+    int address;		// first instruction
+    char *name;
+    int executed;		// instructions executed in the procedure
+};
+
+// The following class collects the counts for all user programs.
+
+class Profiler {
+  public:
+    Profiler(char *coffFile);	// read the symbols of "coffFile"
+    ~Profiler();
+
+    void CountInstruction(int pc, int prevPC);
+				// "pc" is about to be executed; it starts
+				// a block unless it follows "prevPC"
+    void CountTLBMiss(int pc);	// "pc" missed in the TLB
+    void CountPageFault(int pc);	// "pc" faulted on a page not in memory
+
+    void Print();		// print the hot-spot report
+
+  private:
+    ProfileEntry *buckets[ProfileBuckets];
+    int numEntries;
+    ProfileEntry *currentBlock;	// block being executed
+    int totalExecuted;
+
+    ProfileSymbol *symbols;	// sorted by address
+    int numSymbols;
+
+    ProfileEntry *Find(int pc);	// entry for "pc", created if needed
+    ProfileSymbol *Lookup(int pc);	// procedure containing "pc"
+    void ReadSymbols(char *coffFile);
+    void PrintLocation(int pc);	// "name+offset", or the bare address
+};
+
+#endif // PROFILE_H
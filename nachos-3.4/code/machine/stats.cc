@@ -22,6 +22,9 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numTLBMisses = numUserInstructions = 0;
+    fastForwardTicks = fastForwardInstructions = 0;
+    numRealTimeJobs = numDeadlineMisses = 0;
 }
 
 //----------------------------------------------------------------------
@@ -35,10 +38,17 @@ Statistics::Print()
 {
     printf("Ticks: total %d, idle %d, system %d, user %d\n", totalTicks, 
 	idleTicks, systemTicks, userTicks);
+    printf("User instructions: %d\n", numUserInstructions);
+    if (fastForwardTicks > 0)
+	printf("Fast-forward: first %d ticks, %d user instructions\n", 
+	    fastForwardTicks, fastForwardInstructions);
     printf("Disk I/O: reads %d, writes %d\n", numDiskReads, numDiskWrites);
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
-    printf("Paging: faults %d\n", numPageFaults);
+    printf("Paging: faults %d, TLB misses %d\n", numPageFaults, numTLBMisses);
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
+    if (numRealTimeJobs > 0)
+	printf("Real-time: jobs %d, deadline misses %d\n", numRealTimeJobs,
+	    numDeadlineMisses);
 }
@@ -33,8 +33,14 @@ class Statistics {
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
+    int numTLBMisses;		// number of lookups that missed in the TLB
+    int numUserInstructions;	// number of user instructions completed
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numRealTimeJobs;	// jobs released to periodic threads, and
+    int numDeadlineMisses;	// how many of them finished late
+    int fastForwardTicks;	// time, and user instructions executed, 
+    int fastForwardInstructions; // before switching to detailed timing
 
     Statistics(); 		// initialize everything to zero
 
@@ -56,5 +62,7 @@ class Statistics {
 #define ConsoleTime 	100	// time to read or write one character
 #define NetworkTime 	100   	// time to send or receive one packet
 #define TimerTicks 	100    	// (average) time between timer interrupts
+#define CacheL2Time	4	// time to fill a cache line from the L2 cache
+#define MemoryTime	20	// time to fill a cache line from memory
 
 #endif // STATS_H
@@ -2,6 +2,7 @@
 //  
 
 #include "synchconsole.h"
+#include "system.h"
 
 static void
 ConsoleWriteDone (int arg)
@@ -31,6 +32,7 @@ SynchConsole::PutChar(char ch)
 {
 	wlock->Acquire();			
 	console->PutChar(ch);
+    scheduler->IOWait(currentThread);
     wSem->P();			// wait for interrupt
     wlock->Release();
 }
@@ -40,6 +42,7 @@ SynchConsole::GetChar()
 {
 	rlock->Acquire();			
 	char c = console->GetChar();
+    scheduler->IOWait(currentThread);
     rSem->P();			// wait for interrupt
     rlock->Release();
     return c;
@@ -45,6 +45,11 @@ extern "C" {
 #include <fcntl.h>
 #include <sys/time.h>
 #endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <errno.h>
+#define HOST_EPOLL
+#endif
 
 
 // UNIX routines called by procedures in this file 
@@ -103,16 +108,9 @@ void exit(int);
 //----------------------------------------------------------------------
 // PollFile
 // 	Check open file or open socket to see if there are any 
-//	characters that can be read immediately.  If so, read them
-//	in, and return TRUE.
-//
-//	In the network case, if there are no threads for us to run,
-//	and no characters to be read,
-//	we need to give the other side a chance to get our host's CPU
-//	(otherwise, we'll go really slowly, since UNIX time-slices
-//	infrequently, and this would be like busy-waiting).  So we
-//	delay for a short fixed time, before allowing ourselves to be
-//	re-scheduled (sort of like a Yield, but cast in terms of UNIX).
+//	characters that can be read immediately.  If so, return TRUE.
+//	Never waits: an idle Nachos waits for input in WaitForFiles
+//	instead.
 //
 //	"fd" -- the file descriptor of the file to be polled
 //----------------------------------------------------------------------
@@ -123,12 +121,8 @@ PollFile(int fd)
     int rfd = (1 << fd), wfd = 0, xfd = 0, retVal;
     struct timeval pollTime;
 
-// decide how long to wait if there are no characters on the file
     pollTime.tv_sec = 0;
-    if (interrupt->getStatus() == IdleMode)
-        pollTime.tv_usec = 20000;              	// delay to let other nachos run
-    else
-        pollTime.tv_usec = 0;                 	// no delay
+    pollTime.tv_usec = 0;			// no delay
 
 // poll file or socket
 #if (defined(HOST_i386) || defined(HOST_SPARC)) 
@@ -143,6 +137,130 @@ PollFile(int fd)
     return TRUE;
 }
 
+// The host files being watched for input.  Each is reported once by
+// WaitForFiles, and then not again until it is re-armed by WatchFile.
+// With epoll, the kernel keeps the set (one-shot, so reporting a file
+// disarms it); files epoll refuses -- plain files -- are always
+// readable, and are reported without asking.
+
+static bool watchArmed[MaxHostFiles];	// report this file when readable
+#ifdef HOST_EPOLL
+static int epollFd = -1;		// the host's set of watched files
+static bool epollAdded[MaxHostFiles];	// file has been added to the set
+static bool plainFile[MaxHostFiles];	// epoll refused it
+#endif
+
+//----------------------------------------------------------------------
+// WatchFile
+// 	Arrange for the next WaitForFiles to report "fd", once it has
+//	characters to be read.
+//----------------------------------------------------------------------
+
+void
+WatchFile(int fd)
+{
+    ASSERT((fd >= 0) && (fd < MaxHostFiles));
+    watchArmed[fd] = TRUE;
+#ifdef HOST_EPOLL
+    struct epoll_event event;
+    int retVal;
+
+    if (plainFile[fd])
+	return;
+    if (epollFd < 0) {
+	epollFd = epoll_create(MaxHostFiles);
+	ASSERT(epollFd >= 0);
+    }
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.fd = fd;
+    if (epollAdded[fd])
+	retVal = epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+    else {
+	retVal = epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+	if ((retVal < 0) && (errno == EPERM)) {
+	    plainFile[fd] = TRUE;
+	    return;
+	}
+	epollAdded[fd] = TRUE;
+    }
+    ASSERT(retVal == 0);
+#endif
+}
+
+//----------------------------------------------------------------------
+// IgnoreFile
+// 	Stop watching "fd", before it is closed.
+//----------------------------------------------------------------------
+
+void
+IgnoreFile(int fd)
+{
+    ASSERT((fd >= 0) && (fd < MaxHostFiles));
+    watchArmed[fd] = FALSE;
+#ifdef HOST_EPOLL
+    if (epollAdded[fd])
+	(void) epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+    epollAdded[fd] = plainFile[fd] = FALSE;
+#endif
+}
+
+//----------------------------------------------------------------------
+// WaitForFiles
+// 	Put the file descriptors of watched files that have characters
+//	to be read into "ready", and return how many there are.  Each
+//	is disarmed: WatchFile it again to hear about more input.
+//
+//	"ready" -- where to put the readable file descriptors
+//	"maxReady" -- how many fit in "ready"
+//	"block" -- if TRUE and nothing is readable yet, wait for input
+//		rather than returning 0
+//----------------------------------------------------------------------
+
+int
+WaitForFiles(int *ready, int maxReady, bool block)
+{
+    int numReady = 0, count, fd;
+
+#ifdef HOST_EPOLL
+    struct epoll_event events[MaxHostFiles];
+
+    for (fd = 0; (fd < MaxHostFiles) && (numReady < maxReady); fd++)
+	if (watchArmed[fd] && plainFile[fd]) {
+	    watchArmed[fd] = FALSE;
+	    ready[numReady++] = fd;
+	}
+    if ((epollFd < 0) || (numReady == maxReady))
+	return numReady;
+    do
+	count = epoll_wait(epollFd, events, maxReady - numReady,
+			(block && (numReady == 0)) ? -1 : 0);
+    while ((count < 0) && (errno == EINTR));
+    ASSERT(count >= 0);
+    for (int i = 0; i < count; i++) {
+	fd = events[i].data.fd;
+	watchArmed[fd] = FALSE;
+	ready[numReady++] = fd;
+    }
+#else
+    struct timeval pollTime;
+    fd_set rfd;
+
+    FD_ZERO(&rfd);
+    for (fd = 0; fd < MaxHostFiles; fd++)
+	if (watchArmed[fd])
+	    FD_SET(fd, &rfd);
+    pollTime.tv_sec = pollTime.tv_usec = 0;
+    count = select(MaxHostFiles, &rfd, NULL, NULL, block ? NULL : &pollTime);
+    for (fd = 0; (count > 0) && (fd < MaxHostFiles) && 
+			(numReady < maxReady); fd++)
+	if (watchArmed[fd] && FD_ISSET(fd, &rfd)) {
+	    watchArmed[fd] = FALSE;
+	    ready[numReady++] = fd;
+	}
+#endif
+    return numReady;
+}
+
 //----------------------------------------------------------------------
 // OpenForWrite
 // 	Open a file for writing.  Create it if it doesn't exist; truncate it 
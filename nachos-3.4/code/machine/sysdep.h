@@ -17,6 +17,14 @@
 // If no characters in the file, return without waiting.
 extern bool PollFile(int fd);
 
+// Watch host files for input, so that an idle Nachos can wait for it
+// rather than poll.  A watched file is reported once, when it becomes
+// readable, and must be watched again to be reported again.
+#define MaxHostFiles	64	// file descriptors that can be watched
+extern void WatchFile(int fd);
+extern void IgnoreFile(int fd);
+extern int WaitForFiles(int *ready, int maxReady, bool block);
+
 // File operations: open/read/write/lseek/close, and check for error
 // For simulating the disk and the console devices.
 extern int OpenForWrite(char *name);
@@ -46,12 +46,55 @@ Timer::Timer(VoidFunctionPtr timerHandler, int callArg, bool doRandom)
     randomize = doRandom;
     handler = timerHandler;
     arg = callArg; 
+    running = FALSE;
 
-    // schedule the first interrupt from the timer device
+    Start();		// schedule the first interrupt from the timer device
+}
+
+//----------------------------------------------------------------------
+// Timer::Start, Timer::Stop
+//      Turn the timer on, so that it interrupts a time slice from now
+//	and every time slice after that; or off, taking back its next
+//	interrupt.  A kernel that only needs time slices some of the
+//	time can keep the timer off the rest of the time.
+//----------------------------------------------------------------------
+
+void
+Timer::Start()
+{
+    if (running)
+	return;
+    running = TRUE;
     interrupt->Schedule(TimerHandler, (int) this, TimeOfNextInterrupt(), 
 		TimerInt); 
 }
 
+void
+Timer::Stop()
+{
+    if (!running)
+	return;
+    running = FALSE;
+    (void) interrupt->Cancel(TimerHandler, (int) this);
+}
+
+//----------------------------------------------------------------------
+// Timer::SetAlarm
+//      Arrange for a one-shot interrupt, apart from the time slices:
+//	"alarmHandler" is called (with interrupts disabled) with
+//	"alarmArg", "fromNow" ticks from now.  Any number of alarms may
+//	be pending at once.
+//
+//	Unlike the time-slice interrupt, a pending alarm keeps an idle
+//	Nachos from halting, since a thread is waiting for it.
+//----------------------------------------------------------------------
+
+void
+Timer::SetAlarm(int fromNow, VoidFunctionPtr alarmHandler, int alarmArg)
+{
+    interrupt->Schedule(alarmHandler, alarmArg, fromNow, AlarmInt);
+}
+
 //----------------------------------------------------------------------
 // Timer::TimerExpired
 //      Routine to simulate the interrupt generated by the hardware 
@@ -31,6 +31,14 @@ class Timer {
 				// handler "timerHandler" every time slice.
     ~Timer() {}
 
+    void Start();		// Interrupt every time slice from now on
+    void Stop();		// No more interrupts until Start
+    bool IsRunning() { return running; }
+
+    void SetAlarm(int fromNow, VoidFunctionPtr alarmHandler, int alarmArg);
+				// Call "alarmHandler" once, "fromNow"
+				// ticks from now
+
 // Internal routines to the timer emulation -- DO NOT call these
 
     void TimerExpired();	// called internally when the hardware
@@ -41,6 +49,7 @@ class Timer {
 
   private:
     bool randomize;		// set if we need to use a random timeout delay
+    bool running;		// is an interrupt scheduled?
     VoidFunctionPtr handler;	// timer interrupt handler 
     int arg;			// argument to pass to interrupt handler
 
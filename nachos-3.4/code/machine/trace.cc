@@ -0,0 +1,126 @@
+// trace.cc 
+//	Routines to record an instruction trace.  See trace.h for the
+//	file format.
+
+#include "copyright.h"
+#include "trace.h"
+#include "mipssim.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// TraceKind
+// 	The kind of tag byte for an instruction with opcode "opCode".
+//----------------------------------------------------------------------
+
+static int
+TraceKind(int opCode)
+{
+    switch (opCode) {
+      case OP_LB: case OP_LBU: case OP_LH: case OP_LHU:
+      case OP_LW: case OP_LWL: case OP_LWR:
+	return TraceLoad;
+      case OP_SB: case OP_SH: case OP_SW: case OP_SWL: case OP_SWR:
+	return TraceStore;
+      default:
+	return TraceNone;
+    }
+}
+
+//----------------------------------------------------------------------
+// TraceRecorder::TraceRecorder
+// 	Create the UNIX file "fileName" and write the trace header.
+//----------------------------------------------------------------------
+
+TraceRecorder::TraceRecorder(char *fileName)
+{
+    int magic = TraceMagic;
+
+    fd = OpenForWrite(fileName);
+    WriteFile(fd, (char *) &magic, sizeof(magic));
+    used = 0;
+    lastPC = -4;		// so that a trace starting at 0 costs nothing
+    lastAddr = 0;
+    numRecords = 0;
+}
+
+//----------------------------------------------------------------------
+// TraceRecorder::~TraceRecorder
+// 	Write out what is still buffered, and close the trace.
+//----------------------------------------------------------------------
+
+TraceRecorder::~TraceRecorder()
+{
+    Flush();
+    Close(fd);
+    DEBUG('m', "Trace: %d instructions recorded\n", numRecords);
+}
+
+void
+TraceRecorder::Flush()
+{
+    if (used > 0)
+	WriteFile(fd, buffer, used);
+    used = 0;
+}
+
+void
+TraceRecorder::PutByte(int byte)
+{
+    if (used == TraceBufferSize)
+	Flush();
+    buffer[used++] = (char) byte;
+}
+
+//----------------------------------------------------------------------
+// TraceRecorder::PutNumber
+// 	Append a signed number, zigzag encoded so that small negative
+//	numbers are short too, 7 bits a byte.
+//----------------------------------------------------------------------
+
+void
+TraceRecorder::PutNumber(int n)
+{
+    unsigned int zigzag = ((unsigned int) n << 1) ^ (unsigned int) (n >> 31);
+
+    while (zigzag >= 0x80) {
+	PutByte((zigzag & 0x7f) | 0x80);
+	zigzag >>= 7;
+    }
+    PutByte(zigzag);
+}
+
+//----------------------------------------------------------------------
+// TraceRecorder::Record
+// 	Append an instruction that has just completed.
+//
+//	"pc" -- where it was
+//	"opCode" -- what it was (mipssim.h)
+//	"memAddr" -- the virtual address a load or store accessed
+//----------------------------------------------------------------------
+
+void
+TraceRecorder::Record(int pc, int opCode, int memAddr)
+{
+    int kind = TraceKind(opCode);
+
+    PutByte((opCode << 2) | kind);
+    PutNumber(pc - (lastPC + 4));
+    lastPC = pc;
+    if (kind != TraceNone) {
+	PutNumber(memAddr - lastAddr);
+	lastAddr = memAddr;
+    }
+    numRecords++;
+}
+
+//----------------------------------------------------------------------
+// TraceRecorder::SwitchSpace
+// 	Record that the instructions that follow belong to process "pid".
+//----------------------------------------------------------------------
+
+void
+TraceRecorder::SwitchSpace(int pid)
+{
+    PutByte(TraceSwitch);
+    PutNumber(pid);
+}
@@ -0,0 +1,69 @@
+// trace.h 
+//	Data structures to record a compact binary trace of the 
+//	instructions a user program executes, for replaying through
+//	cache, TLB and page replacement models (bin/tracesim) without
+//	running the program again.
+//
+//	A trace file starts with the word TraceMagic, in host byte order.
+//	Each instruction is then one tag byte:
+//
+//		(opCode << 2) | kind
+//
+//	where opCode is the simulator's opcode (mipssim.h) and kind is
+//	TraceNone, TraceLoad or TraceStore, followed by a number: its PC
+//	minus (the previous PC + 4).  A load or store is followed by a 
+//	second number, its effective address minus that of the previous
+//	load or store.  So a straight line of code with sequential data
+//	takes one or two bytes an instruction.
+//
+//	A tag byte of kind TraceSwitch (and opCode 0) marks a switch to
+//	another address space, whose pid follows as a number.
+//
+//	Numbers are signed, stored "zigzag" encoded (0, -1, 1, -2 ... as
+//	0, 1, 2, 3 ...) 7 bits a byte, low bits first, with the top bit
+//	set in every byte but the last.
+//
+//	Instructions that trap are not recorded; a faulting instruction
+//	is recorded when it is restarted and completes.  Tracing (-trace)
+//	uses the interpreter, whichever engine was chosen.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define TraceMagic	0x3152544e	// "NTR1"
+
+#define TraceNone	0		// kinds of tag byte
+#define TraceLoad	1
+#define TraceStore	2
+#define TraceSwitch	3
+
+#define TraceBufferSize	8192		// bytes written at a time
+
+class TraceRecorder {
+  public:
+    TraceRecorder(char *fileName);	// start a trace in a UNIX file
+    ~TraceRecorder();			// write out the rest, and close it
+
+    void Record(int pc, int opCode, int memAddr);
+				// record an instruction that completed;
+				// "memAddr" is only used for loads and 
+				// stores
+    void SwitchSpace(int pid);	// record a context switch
+
+  private:
+    void PutByte(int byte);
+    void PutNumber(int n);	// zigzag and 7 bits a byte
+    void Flush();		// write out the buffer
+
+    int fd;			// the trace file
+    char buffer[TraceBufferSize];
+    int used;			// bytes of buffer filled
+    int lastPC;			// PC of the previous instruction
+    int lastAddr;		// address of the previous load or store
+    int numRecords;		// instructions recorded
+};
+
+#endif // TRACE_H
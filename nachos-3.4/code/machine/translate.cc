@@ -33,6 +33,7 @@
 #include "machine.h"
 #include "addrspace.h"
 #include "system.h"
+#include "cache.h"
 
 // Routines for converting Words and Short Words to and from the
 // simulated machine's format of little endian.  These end up
@@ -71,6 +72,53 @@ unsigned short
 ShortToMachine(unsigned short shortword) { return ShortToHost(shortword); }
 
 
+//----------------------------------------------------------------------
+// Machine::FlushHostTLB
+//	Empty the host TLB.  Called by the kernel whenever it changes a
+//	translation in the TLB or page table, so that no stale host pointer
+//	can be used.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushHostTLB()
+{
+    for (int i = 0; i < HostTLBSize; i++)
+	hostTLB[i].virtualPage = -1;
+    hostTLBPageTable = pageTable;
+}
+
+//----------------------------------------------------------------------
+// Machine::HostAddress
+//	Look up the host TLB for an access of "size" bytes at "virtAddr".
+//	On a hit, set the use/dirty bits (and the TLB hit count) exactly as
+//	Translate would, and return a host pointer to the data.
+//
+//	Returns NULL if the access must go through Translate -- the page
+//	is not cached, the access is unaligned, or it is a write to a
+//	read-only page -- so that every exception is raised by Translate.
+//----------------------------------------------------------------------
+
+inline char *
+Machine::HostAddress(int virtAddr, int size, bool writing)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    HostTLBEntry *h = &hostTLB[vpn % HostTLBSize];
+    TranslationEntry *entry = h->entry;
+
+    if (pageTable != hostTLBPageTable)		// address space switched
+	FlushHostTLB();
+    if (h->virtualPage != (int) vpn || (virtAddr & (size - 1))
+		|| !entry->valid || (writing && !h->writable))
+	return NULL;
+    entry->use = TRUE;
+    if (writing)
+	entry->dirty = TRUE;
+    if (tlb != NULL)
+	entry->hit++;
+    lastEntry = entry;
+    return h->page + (unsigned) virtAddr % PageSize;
+}
+
 //----------------------------------------------------------------------
 // Machine::ReadMem
 //      Read "size" (1, 2, or 4) bytes of virtual memory at "addr" into 
@@ -90,27 +138,34 @@ Machine::ReadMem(int addr, int size, int *value)
     int data;
     ExceptionType exception;
     int physicalAddress;
+    char *host;
     
-    DEBUG('a', "Reading VA 0x%x, size %d\n", addr, size);
+    host = hostTLBEnabled ? HostAddress(addr, size, FALSE) : NULL;
+    if (host == NULL) {
+	DEBUG('a', "Reading VA 0x%x, size %d\n", addr, size);
     
-    exception = Translate(addr, &physicalAddress, size, FALSE);
-    if (exception != NoException) {
-	machine->RaiseException(exception, addr);
-	return FALSE;
+	exception = Translate(addr, &physicalAddress, size, FALSE);
+	if (exception != NoException) {
+	    RaiseException(exception, addr);
+	    return FALSE;
+	}
+	host = &mainMemory[physicalAddress];
     }
+    if (dcache != NULL)
+	Stall(dcache->Access(host - mainMemory));
     switch (size) {
       case 1:
-	data = machine->mainMemory[physicalAddress];
+	data = *host;
 	*value = data;
 	break;
 	
       case 2:
-	data = *(unsigned short *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned short *) host;
 	*value = ShortToHost(data);
 	break;
 	
       case 4:
-	data = *(unsigned int *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned int *) host;
 	*value = WordToHost(data);
 	break;
 
@@ -139,26 +194,35 @@ Machine::WriteMem(int addr, int size, int value)
 {
     ExceptionType exception;
     int physicalAddress;
+    char *host;
      
-    DEBUG('a', "Writing VA 0x%x, size %d, value 0x%x\n", addr, size, value);
+    host = hostTLBEnabled ? HostAddress(addr, size, TRUE) : NULL;
+    if (host == NULL) {
+	DEBUG('a', "Writing VA 0x%x, size %d, value 0x%x\n", addr, size, value);
 
-    exception = Translate(addr, &physicalAddress, size, TRUE);
-    if (exception != NoException) {
-	machine->RaiseException(exception, addr);
-	return FALSE;
+	exception = Translate(addr, &physicalAddress, size, TRUE);
+	if (exception != NoException) {
+	    RaiseException(exception, addr);
+	    return FALSE;
+	}
+	host = &mainMemory[physicalAddress];
     }
+    if (dcache != NULL)
+	Stall(dcache->Access(host - mainMemory));
+    if (pageDecoded[(host - mainMemory) / PageSize])	// code may change
+	InvalidateDecodedPage((host - mainMemory) / PageSize);
     switch (size) {
       case 1:
-	machine->mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
+	*host = (unsigned char) (value & 0xff);
 	break;
 
       case 2:
-	*(unsigned short *) &machine->mainMemory[physicalAddress]
+	*(unsigned short *) host
 		= ShortToMachine((unsigned short) (value & 0xffff));
 	break;
       
       case 4:
-	*(unsigned int *) &machine->mainMemory[physicalAddress]
+	*(unsigned int *) host
 		= WordToMachine((unsigned int) value);
 	break;
 	
@@ -168,6 +232,92 @@ Machine::WriteMem(int addr, int size, int value)
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Machine::TLBSet
+// 	Return the index of the first entry of the TLB set in which the
+//	translation for virtual page "vpn" of address space "space" 
+//	may be found.  A set is TLBWays consecutive entries, so with the
+//	default (fully associative) TLB there is only the one set, at 0.
+//----------------------------------------------------------------------
+
+int
+Machine::TLBSet(int vpn, int space)
+{
+    return ((unsigned) (vpn + space * 314) % (TLBSize / TLBWays)) * TLBWays;
+}
+
+//----------------------------------------------------------------------
+// Machine::TLBVictim
+// 	Return the TLB entry to replace to make room for virtual page
+//	"vpn" of the running address space: an invalid entry of its set, 
+//	if there is one, else the one with the fewest hits.  Hit counts
+//	of the set start again from zero.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+Machine::TLBVictim(int vpn)
+{
+    int set = TLBSet(vpn, asid);
+    int minHit = 99999;
+    int oldest = set;
+
+    for (int i = set; i < set + TLBWays; i++) {
+	if (!tlb[i].valid) {
+	    oldest = i;
+	    break;
+	}
+	if (tlb[i].hit < minHit) {
+	    minHit = tlb[i].hit;
+	    oldest = i;
+	}
+    }
+    for (int i = set; i < set + TLBWays; i++)
+	tlb[i].hit = 0;
+    return &tlb[oldest];
+}
+
+//----------------------------------------------------------------------
+// Machine::WalkPageTable
+// 	The TLB has no entry for virtual page "vpn": look it up in the 
+//	two-level page table at "pageDirectory", and if it is valid there,
+//	copy it into the TLB, as hardware with a page-table walker would.
+//	The "hit" field of the page table entry counts these refills, 
+//	for the kernel's replacement policy.
+//
+//	Returns the new TLB entry, or NULL if the page is not mapped 
+//	(the kernel has to handle the page fault).
+//----------------------------------------------------------------------
+
+TranslationEntry *
+Machine::WalkPageTable(int vpn)
+{
+    TranslationEntry *table, *pte, *entry;
+
+    if (vpn / WalkTableSize >= WalkDirSize)
+	return NULL;
+    table = pageDirectory[vpn / WalkTableSize];
+    if (table == NULL)
+	return NULL;
+    pte = &table[vpn % WalkTableSize];
+    if (!pte->valid)
+	return NULL;
+    DEBUG('a', "walked page table for vpn %d: ppn %d\n", vpn, 
+		pte->physicalPage);
+
+    entry = TLBVictim(vpn);
+    FlushHostTLB();			// the entry may be cached
+    entry->virtualPage = vpn;
+    entry->physicalPage = pte->physicalPage;
+    entry->readOnly = pte->readOnly;
+    entry->valid = TRUE;
+    entry->use = FALSE;
+    entry->dirty = FALSE;
+    entry->asid = asid;
+    entry->hit = 1;			// as if found by the lookup
+    pte->hit++;
+    return entry;
+}
+
 //----------------------------------------------------------------------
 // Machine::Translate
 // 	Translate a virtual address into a physical address, using 
@@ -220,12 +370,19 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 		}
 		entry = &pageTable[vpn];
     } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
-    	    if (tlb[i].valid && (tlb[i].virtualPage == vpn)) {
+	int set = TLBSet(vpn, asid);
+
+        for (entry = NULL, i = set; i < set + TLBWays; i++)
+    	    if (tlb[i].valid && (tlb[i].virtualPage == vpn)
+				&& (tlb[i].asid == asid)) {
 				entry = &tlb[i];			// FOUND!
 				entry -> hit++;		
 				break;
 	    	}
+		if (entry == NULL)
+		    stats->numTLBMisses++;
+		if ((entry == NULL) && (pageDirectory != NULL))
+		    entry = WalkPageTable(vpn);		// refill in hardware
 		if (entry == NULL) {				// not found
     	    DEBUG('a', "*** no valid TLB entry found for this virtual page!\n");
     	    return PageFaultException;		// really, this is a TLB fault,
@@ -242,13 +399,22 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 
     // if the pageFrame is too big, there is something really wrong! 
     // An invalid translation was loaded into the page table or TLB. 
-    if (pageFrame >= NumPhysPages) { 
+    if (pageFrame >= (unsigned) NumPhysPages) { 
 		DEBUG('a', "*** frame %d > %d!\n", pageFrame, NumPhysPages);
 		return BusErrorException;
     }
     entry->use = TRUE;		// set the use, dirty bits
     if (writing)
 		entry->dirty = TRUE;
+    lastEntry = entry;
+    if (hostTLBEnabled) {		// remember it for ReadMem/WriteMem
+	HostTLBEntry *h = &hostTLB[vpn % HostTLBSize];
+
+	h->virtualPage = vpn;
+	h->entry = entry;
+	h->page = &mainMemory[pageFrame * PageSize];
+	h->writable = !entry->readOnly;
+    }
     *physAddr = pageFrame * PageSize + offset;
     ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
     DEBUG('a', "phys addr = 0x%x\n", *physAddr);
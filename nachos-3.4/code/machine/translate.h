@@ -41,6 +41,8 @@ class TranslationEntry {
     bool dirty;         // This bit is set by the hardware every time the
 			// page is modified.
     int hit; // hit times 
+    int asid;		// The address space this entry belongs to; only 
+			// checked in a TLB (see Machine::asid).
 };
 
 #endif
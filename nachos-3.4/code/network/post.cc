@@ -18,9 +18,21 @@
 
 #include "copyright.h"
 #include "post.h"
+#include "slab.h"
+#include "system.h"
 #ifdef HOST_SPARC
 #include <strings.h>
 #endif
+// Every message received is queued as a Mail, and every message sent
+// is put together in a packet buffer
+static SlabCache mailCache("mail", sizeof(Mail));
+static SlabCache packetCache("packet buffer", MaxPacketSize);
+
+void *Mail::operator new(size_t size)
+{ return mailCache.Alloc(size); }
+void Mail::operator delete(void *p)
+{ mailCache.Free(p); }
+
 //----------------------------------------------------------------------
 // Mail::Mail
 //      Initialize a single mail message, by concatenating the headers to
@@ -122,6 +134,7 @@ void
 MailBox::Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data) 
 { 
     DEBUG('n', "Waiting for mail in mailbox\n");
+    scheduler->IOWait(currentThread);
     Mail *mail = (Mail *) messages->Remove();	// remove message from list;
 						// will wait if list is empty
 
@@ -261,8 +274,9 @@ PostOffice::PostalDelivery()
 void
 PostOffice::Send(PacketHeader pktHdr, MailHeader mailHdr, char* data)
 {
-    char* buffer = new char[MaxPacketSize];	// space to hold concatenated
-						// mailHdr + data
+    char* buffer = (char *) packetCache.Alloc(MaxPacketSize);
+					// space to hold concatenated
+					// mailHdr + data
 
     if (DebugIsEnabled('n')) {
 	printf("Post send: ");
@@ -286,8 +300,8 @@ PostOffice::Send(PacketHeader pktHdr, MailHeader mailHdr, char* data)
 					// ok to send the next message
     sendLock->Release();
 
-    delete [] buffer;			// we've sent the message, so
-					// we can delete our buffer
+    packetCache.Free(buffer);		// we've sent the message, so
+					// we can free our buffer
 }
 
 //----------------------------------------------------------------------
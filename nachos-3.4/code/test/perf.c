@@ -0,0 +1,43 @@
+/* perf.c
+ *	Test program for the performance counters.
+ *
+ *	Ends the fast-forward phase (if any), then reads every counter
+ *	before and after a short loop.  The difference in user
+ *	instructions is passed to Exit, so it shows up in the kernel's
+ *	"Exit:" message; the other differences are left in "delta",
+ *	for looking at with the debugger.
+ *
+ *	Run with "nachos -x ../test/perf", or "nachos -ff 0 -x ../test/perf"
+ *	to skip the start-up code in fast-forward mode.
+ */
+
+#include "syscall.h"
+
+#define N 100
+
+int before[NumPerfCounters];
+int delta[NumPerfCounters];
+int A[N];
+
+int
+main()
+{
+    int i, sum;
+
+    StartTiming();
+    for (i = 0; i < NumPerfCounters; i++)
+	before[i] = PerfCounter(i);
+
+    sum = 0;
+    for (i = 0; i < N; i++) {
+	A[i] = i;
+	sum += A[i];
+    }
+
+    for (i = 0; i < NumPerfCounters; i++)
+	delta[i] = PerfCounter(i) - before[i];
+
+    if (sum != N * (N - 1) / 2)
+	Exit(-1);
+    Exit(delta[PerfInstructions]);
+}
@@ -130,6 +130,22 @@ Yield:
 	j	$31
 	.end Yield
 
+	.globl StartTiming
+	.ent	StartTiming
+StartTiming:
+	addiu $2,$0,SC_StartTiming
+	syscall
+	j	$31
+	.end StartTiming
+
+	.globl PerfCounter
+	.ent	PerfCounter
+PerfCounter:
+	addiu $2,$0,SC_PerfCounter
+	syscall
+	j	$31
+	.end PerfCounter
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
@@ -0,0 +1,253 @@
+// avltree.cc
+//	Routines to manage a balanced binary search tree.  See avltree.h.
+//
+//	The tree is kept AVL-balanced: the heights of the two subtrees of
+//	every node differ by at most one, so its height is O(log n).
+//	Insert and Remove rebalance the nodes on the path they took, on
+//	the way back up.
+
+#include "copyright.h"
+#include "avltree.h"
+#include "slab.h"
+
+static SlabCache nodeCache("tree node", sizeof(AVLNode));
+
+void *AVLNode::operator new(size_t size)
+{ return nodeCache.Alloc(size); }
+void AVLNode::operator delete(void *p)
+{ nodeCache.Free(p); }
+
+//----------------------------------------------------------------------
+// AVLTree::AVLTree, AVLTree::~AVLTree
+// 	Initialize an empty tree; de-allocate a tree's nodes.  The items
+//	belong to the caller.
+//----------------------------------------------------------------------
+
+AVLTree::AVLTree()
+{
+    root = NULL;
+    numEntries = 0;
+    numInserted = 0;
+}
+
+AVLTree::~AVLTree()
+{
+    DeleteNode(root);
+}
+
+void
+AVLTree::DeleteNode(AVLNode *n)
+{
+    if (n == NULL)
+	return;
+    DeleteNode(n->left);
+    DeleteNode(n->right);
+    delete n;
+}
+
+//----------------------------------------------------------------------
+// AVLTree::Before
+// 	Does the entry ("key", "ticket") come before node "n"?
+//----------------------------------------------------------------------
+
+bool
+AVLTree::Before(int key, int ticket, AVLNode *n)
+{
+    return (key < n->key) || ((key == n->key) && (ticket < n->ticket));
+}
+
+//----------------------------------------------------------------------
+// AVLTree::RotateLeft, AVLTree::RotateRight, AVLTree::Balance
+// 	Restore the balance at "n", whose subtrees are balanced but may
+//	differ in height by two, and return the new root of the subtree.
+//----------------------------------------------------------------------
+
+AVLNode *
+AVLTree::RotateLeft(AVLNode *n)
+{
+    AVLNode *r = n->right;
+
+    n->right = r->left;
+    r->left = n;
+    n->height = 1 + max(Height(n->left), Height(n->right));
+    r->height = 1 + max(Height(r->left), Height(r->right));
+    return r;
+}
+
+AVLNode *
+AVLTree::RotateRight(AVLNode *n)
+{
+    AVLNode *l = n->left;
+
+    n->left = l->right;
+    l->right = n;
+    n->height = 1 + max(Height(n->left), Height(n->right));
+    l->height = 1 + max(Height(l->left), Height(l->right));
+    return l;
+}
+
+AVLNode *
+AVLTree::Balance(AVLNode *n)
+{
+    int diff = Height(n->left) - Height(n->right);
+
+    if (diff > 1) {
+	if (Height(n->left->left) < Height(n->left->right))
+	    n->left = RotateLeft(n->left);
+	return RotateRight(n);
+    }
+    if (diff < -1) {
+	if (Height(n->right->right) < Height(n->right->left))
+	    n->right = RotateRight(n->right);
+	return RotateLeft(n);
+    }
+    n->height = 1 + max(Height(n->left), Height(n->right));
+    return n;
+}
+
+//----------------------------------------------------------------------
+// AVLTree::Insert
+// 	Put "item" into the tree, after any entries with the same key.
+//	Return the ticket that, with "key", names it for Remove.
+//----------------------------------------------------------------------
+
+int
+AVLTree::Insert(void *item, int key)
+{
+    AVLNode *node = new AVLNode;
+
+    node->item = item;
+    node->key = key;
+    node->ticket = numInserted++;
+    node->height = 1;
+    node->left = node->right = NULL;
+    root = InsertNode(root, node);
+    numEntries++;
+    return node->ticket;
+}
+
+AVLNode *
+AVLTree::InsertNode(AVLNode *n, AVLNode *node)
+{
+    if (n == NULL)
+	return node;
+    if (Before(node->key, node->ticket, n))
+	n->left = InsertNode(n->left, node);
+    else
+	n->right = InsertNode(n->right, node);
+    return Balance(n);
+}
+
+//----------------------------------------------------------------------
+// AVLTree::Remove
+// 	Take the entry with "key" and "ticket" out of the tree, and
+//	return its item, or NULL if there is no such entry.
+//----------------------------------------------------------------------
+
+void *
+AVLTree::Remove(int key, int ticket)
+{
+    AVLNode *removed = NULL;
+    void *item;
+
+    root = RemoveNode(root, key, ticket, &removed);
+    if (removed == NULL)
+	return NULL;
+    item = removed->item;
+    delete removed;
+    numEntries--;
+    return item;
+}
+
+AVLNode *
+AVLTree::RemoveNode(AVLNode *n, int key, int ticket, AVLNode **removed)
+{
+    if (n == NULL)
+	return NULL;
+    if ((key == n->key) && (ticket == n->ticket)) {
+	AVLNode *successor;
+
+	*removed = n;
+	if (n->left == NULL)
+	    return n->right;
+	if (n->right == NULL)
+	    return n->left;
+	n->right = RemoveSmallest(n->right, &successor);	// replace n
+	successor->left = n->left;			// by the next entry
+	successor->right = n->right;
+	return Balance(successor);
+    }
+    if (Before(key, ticket, n))
+	n->left = RemoveNode(n->left, key, ticket, removed);
+    else
+	n->right = RemoveNode(n->right, key, ticket, removed);
+    return Balance(n);
+}
+
+//----------------------------------------------------------------------
+// AVLTree::First, AVLTree::RemoveFirst
+// 	Return the item with the smallest key (the earliest inserted, if
+//	several have it), and set *keyPtr to its key; or return NULL if
+//	the tree is empty.  RemoveFirst also takes it out of the tree.
+//----------------------------------------------------------------------
+
+void *
+AVLTree::First(int *keyPtr)
+{
+    AVLNode *n = root;
+
+    if (n == NULL)
+	return NULL;
+    while (n->left != NULL)
+	n = n->left;
+    *keyPtr = n->key;
+    return n->item;
+}
+
+void *
+AVLTree::RemoveFirst(int *keyPtr)
+{
+    AVLNode *removed;
+    void *item;
+
+    if (root == NULL)
+	return NULL;
+    root = RemoveSmallest(root, &removed);
+    *keyPtr = removed->key;
+    item = removed->item;
+    delete removed;
+    numEntries--;
+    return item;
+}
+
+AVLNode *
+AVLTree::RemoveSmallest(AVLNode *n, AVLNode **removed)
+{
+    if (n->left == NULL) {
+	*removed = n;
+	return n->right;
+    }
+    n->left = RemoveSmallest(n->left, removed);
+    return Balance(n);
+}
+
+//----------------------------------------------------------------------
+// AVLTree::Mapcar
+// 	Apply "func" to every item in the tree, in order.
+//----------------------------------------------------------------------
+
+void
+AVLTree::Mapcar(VoidFunctionPtr func)
+{
+    MapcarNode(root, func);
+}
+
+void
+AVLTree::MapcarNode(AVLNode *n, VoidFunctionPtr func)
+{
+    if (n == NULL)
+	return;
+    MapcarNode(n->left, func);
+    (*func)((int) n->item);
+    MapcarNode(n->right, func);
+}
@@ -0,0 +1,69 @@
+// avltree.h
+//	Data structures for a balanced (AVL) binary search tree of items,
+//	ordered by an integer key.
+//
+//	Items with equal keys are kept in the order they were inserted,
+//	so the tree can be used as a queue ordered by key (the ready
+//	threads ordered by virtual runtime, in Scheduler::SetFair).
+//	Every operation but Mapcar takes O(log n) time.
+//
+//	Insert returns a ticket which, together with the key, names the
+//	entry exactly; Remove needs both to take an entry out from the
+//	middle of the tree.
+
+#ifndef AVLTREE_H
+#define AVLTREE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// One entry in the tree.  Internal to AVLTree.
+
+class AVLNode {
+  public:
+    void *item;
+    int key;			// what the tree is ordered by, and then
+    int ticket;			// by when the item was inserted
+    int height;			// of the subtree rooted here
+    AVLNode *left, *right;
+
+    void *operator new(size_t size);	// allocated from a slab cache,
+    void operator delete(void *p);	// see slab.h
+};
+
+class AVLTree {
+  public:
+    AVLTree();			// initialize an empty tree
+    ~AVLTree();			// de-allocate it (but not the items)
+
+    int Insert(void *item, int key);	// Put item into the tree, and
+					// return its ticket
+    void *Remove(int key, int ticket);	// Take the entry with this key
+					// and ticket out; NULL if none
+    void *First(int *keyPtr);		// The smallest entry, or NULL
+    void *RemoveFirst(int *keyPtr);	// ... taken out of the tree
+
+    bool IsEmpty() { return root == NULL; }
+    int NumEntries() { return numEntries; }
+    void Mapcar(VoidFunctionPtr func);	// Apply "func" to every item,
+					// smallest first
+
+  private:
+    AVLNode *root;
+    int numEntries;
+    int numInserted;		// tickets handed out so far
+
+    static int Height(AVLNode *n) { return (n == NULL) ? 0 : n->height; }
+    static bool Before(int key, int ticket, AVLNode *n);
+    static AVLNode *Balance(AVLNode *n);
+    static AVLNode *RotateLeft(AVLNode *n);
+    static AVLNode *RotateRight(AVLNode *n);
+    static AVLNode *InsertNode(AVLNode *n, AVLNode *node);
+    static AVLNode *RemoveNode(AVLNode *n, int key, int ticket,
+				AVLNode **removed);
+    static AVLNode *RemoveSmallest(AVLNode *n, AVLNode **removed);
+    static void MapcarNode(AVLNode *n, VoidFunctionPtr func);
+    static void DeleteNode(AVLNode *n);
+};
+
+#endif // AVLTREE_H
@@ -17,6 +17,15 @@
 
 #include "copyright.h"
 #include "list.h"
+#include "slab.h"
+
+// Every Append, Prepend and SortedInsert needs a list element
+static SlabCache elementCache("list element", sizeof(ListElement));
+
+void *ListElement::operator new(size_t size)
+{ return elementCache.Alloc(size); }
+void ListElement::operator delete(void *p)
+{ elementCache.Free(p); }
 
 //----------------------------------------------------------------------
 // ListElement::ListElement
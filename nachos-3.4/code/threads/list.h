@@ -28,6 +28,9 @@ class ListElement {
    public:
      ListElement(void *itemPtr, int sortKey);	// initialize a list element
 
+     void *operator new(size_t size);	// allocated from a slab cache,
+     void operator delete(void *p);	// see slab.h
+
      ListElement *next;		// next element on list, 
 				// NULL if this is the last
      int key;		    	// priority, for a sorted list
@@ -8,8 +8,14 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
-//		-s -x <nachos file> -c <consoleIn> <consoleOut>
+// Usage: nachos -d <debugflags> -rs <random seed #> -tickless -mlfq -cfs
+//		-s -bb -jit -x <nachos file> -c <consoleIn> <consoleOut>
+//		-pages <#> -pagesize <bytes> -tlb <#> -tlbways <#> -asid -walk
+//		-prof <coff file> -l1 <bytes> <ways> <line bytes>
+//		-l2 <bytes> <ways> <line bytes>
+//		-save <unix file> <ticks> -restore <unix file>
+//		-trace <unix file> -ff <ticks> -ffi <instructions>
+//		-cost <unix file>
 //		-f -cp <unix file> <nachos file>
 //		-p <nachos file> -r <nachos file> -l -D -t
 //              -n <network reliability> -m <machine id>
@@ -21,11 +27,44 @@
 //		
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -tickless stops the timer while a time slice could not switch
+//	threads (one runnable thread, or an idle system)
+//    -mlfq schedules with multilevel feedback: CPU-bound threads are
+//	demoted, and threads waiting for I/O boosted (not with -rs)
+//    -cfs schedules completely fairly: the ready thread that has had the
+//	least CPU time, weighted by priority, runs next (overrides -mlfq)
 //    -z prints the copyright message
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
+//    -bb executes user programs with the basic-block engine
+//    -jit executes user programs by translating their hot blocks
 //    -x runs a user program
+//    -pages sets the number of pages of physical memory (default 32)
+//    -pagesize sets the page size in bytes, a multiple of 4 (default 128)
+//    -tlb sets the number of TLB entries (default 4)
+//    -tlbways sets the entries per TLB set (default: fully associative)
+//    -asid tags TLB entries with the process, instead of flushing the
+//	TLB on every context switch
+//    -walk refills the TLB from a page table walked in hardware, so that
+//	only pages that are not in memory trap to the kernel
+//    -prof profiles user programs, and prints the hot spots on halt,
+//	naming procedures from the symbols in the given COFF file
+//    -l1 simulates the timing of L1 instruction and data caches, each
+//	of the given size, associativity and line size
+//    -l2 adds an L2 cache behind them (only with -l1)
+//    -trace records every user instruction, with the address of each
+//	load and store, in a compact binary file for bin/tracesim
+//    -cost charges each user instruction by its class (ALU, load,
+//	multiply ...), with the ticks given in a file (see costmodel.h)
+//    -ff runs user programs with no timing detail (no caches, profiling
+//	or tracing, and one tick disk requests) until the given tick, 
+//	or with 0, until a user program calls StartTiming()
+//    -ffi does the same for the given number of user instructions
+//    -save writes a checkpoint of the user program to the given file
+//	once simulated time reaches the given tick (see checkpoint.h)
+//    -restore starts the program given to -x from a checkpoint, with
+//	the same machine options as the run that saved it
 //    -c tests the console
 //
 //  FILESYS
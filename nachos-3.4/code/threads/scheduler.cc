@@ -11,8 +11,21 @@
 //	end up calling FindNextToRun(), and that would put us in an 
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	Threads are run in priority order, FIFO within a priority.  Each
+//	priority has its own queue, linked through the threads themselves
+//	so that a thread can be taken off from anywhere in constant time,
+//	and a bitmap records which queues are not empty, so that the best
+//	one is found with a find-first-set per 32 priorities.  Every
+//	scheduling decision thus takes constant time, however many
+//	threads are ready.
+//
+//	Alternatively (SetFair), the ready threads are kept in a balanced
+//	tree ordered by virtual runtime, and priorities only weight how
+//	fast that runs.
+//
+//	Either way, periodic real-time threads (Thread::SetPeriodic) come
+//	first: they are kept in a tree of their own, ordered by deadline,
+//	and the earliest deadline runs.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -21,6 +34,7 @@
 #include "copyright.h"
 #include "scheduler.h"
 #include "system.h"
+#include <strings.h>			// for ffs
 
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
@@ -31,21 +45,46 @@ Scheduler::Scheduler()
 {
     for (int i = 0; i < MaxThreadPriority; ++i)
     {
-        readyLists[i] = new List;
+        readyHead[i] = readyTail[i] = NULL;
+    }
+    for (int i = 0; i < ReadyMaskWords; ++i)
+    {
+        readyMask[i] = 0;
+    }
+    tickless = FALSE;
+    anyReadyPreempts = FALSE;
+    mlfq = FALSE;
+    nextAging = 0;
+    fair = FALSE;
+    fairTree = NULL;
+    minVruntime = 0;
+    edfTree = new AVLTree();
+    totalDensity = 0.0;
+
+    // each priority gets 2^(1/8) times the CPU share of the next lower
+    // one, so 8 priorities apart is twice the share
+    double w = FairNormalWeight;
+    for (int i = NormalThreadPriority; i >= 0; --i, w *= 1.0905)
+    {
+        weight[i] = (int) w;
+    }
+    w = FairNormalWeight;
+    for (int i = NormalThreadPriority; i < MaxThreadPriority; ++i, w /= 1.0905)
+    {
+        weight[i] = max((int) w, 1);
     }
 } 
 
 //----------------------------------------------------------------------
 // Scheduler::~Scheduler
-// 	De-allocate the list of ready threads.
+// 	De-allocate the list of ready threads.  The threads on it are
+//	not ours to delete.
 //----------------------------------------------------------------------
 
 Scheduler::~Scheduler()
 { 
-    for (int i = 0; i < MaxThreadPriority; ++i)
-    {
-        delete readyLists[i];
-    }
+    delete fairTree;
+    delete edfTree;
 } 
 //----------------------------------------------------------------------
 // Scheduler::priorityChanged
@@ -54,10 +93,535 @@ Scheduler::~Scheduler()
 void 
 Scheduler::priorityChanged(Thread* aThread,int oldPriority)
 {
-    List *readyList = readyLists[oldPriority];    
-    readyList->Remove((void *)aThread);
-    List *newReadyList = readyLists[aThread->getPriority()];
-    newReadyList->Append((void *)aThread);
+    Dequeue(aThread, oldPriority);
+    Enqueue(aThread);
+    UpdateTimer();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SetMlfq
+// 	Turn on multilevel feedback: priorities follow how threads
+//	behave, not just what setPriority said.
+//
+//	- Lower priorities get longer time slices (Quantum).
+//	- A thread that runs for a whole time slice is CPU-bound, and is
+//	  demoted MlfqStep priorities (QuantumUsed).
+//	- A thread about to wait for a device (disk, console, network)
+//	  is I/O-bound, and is boosted MlfqStep priorities, though never
+//	  above its base priority (IOWait).
+//	- Every MlfqAgingTime ticks, every thread goes back to its base
+//	  priority, so that demoted threads do not starve (Age).
+//
+//	Interactive and I/O-bound threads thus run soon after their I/O
+//	completes, while CPU-bound ones share what is left.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SetMlfq()
+{
+    mlfq = TRUE;
+    nextAging = stats->totalTicks + MlfqAgingTime;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Quantum
+// 	Return how many timer interrupts a thread of "priority" may run
+//	for before it should yield: 1, or with multilevel feedback,
+//	1 more for each MlfqStep priorities below the highest.
+//----------------------------------------------------------------------
+
+int
+Scheduler::Quantum(int priority)
+{
+    if (!mlfq)
+    {
+        return 1;
+    }
+    return 1 + priority / MlfqStep;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::QuantumUsed
+// 	"thread" has run for a whole time slice: with multilevel
+//	feedback, demote it, and start its next time slice at the new
+//	priority.
+//----------------------------------------------------------------------
+
+void
+Scheduler::QuantumUsed(Thread *thread)
+{
+    if (!mlfq || thread->isPeriodic())
+    {
+        return;
+    }
+    int prio = thread->getOwnPriority() + MlfqStep;
+
+    if (prio > LowThreadPriority)
+    {
+        prio = LowThreadPriority;
+    }
+    DEBUG('t', "Demoting CPU-bound thread %s to priority %d\n",
+                thread->getName(), prio);
+    thread->adjustPriority(prio);
+    thread->resetTimerTick();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::IOWait
+// 	"thread" is about to wait for a device: with multilevel feedback,
+//	boost it, but not above its base priority.
+//----------------------------------------------------------------------
+
+void
+Scheduler::IOWait(Thread *thread)
+{
+    if (!mlfq)
+    {
+        return;
+    }
+    int prio = thread->getOwnPriority() - MlfqStep;
+
+    if (prio < thread->getBasePriority())
+    {
+        prio = thread->getBasePriority();
+    }
+    if (prio != thread->getOwnPriority())
+    {
+        DEBUG('t', "Boosting I/O-bound thread %s to priority %d\n",
+                thread->getName(), prio);
+        thread->adjustPriority(prio);
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Age
+// 	Called on every timer interrupt: with multilevel feedback, once
+//	every MlfqAgingTime ticks, put every thread back at its base
+//	priority.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Age()
+{
+    if (!mlfq || (stats->totalTicks < nextAging))
+    {
+        return;
+    }
+    nextAging = stats->totalTicks + MlfqAgingTime;
+    DEBUG('t', "Raising every thread back to its base priority\n");
+    for (int pid = 0; pid < MaxProcessNum; ++pid)
+    {
+        Thread *t = Thread::GetThread(pid);
+
+        if (t != NULL)
+        {
+            t->adjustPriority(t->getBasePriority());
+        }
+    }
+    UpdateTimer();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SetFair
+// 	Turn on completely fair scheduling: run the ready thread that has
+//	had the least CPU time, so that every thread gets its share and
+//	none starves, however many are CPU-bound.
+//
+//	Each thread's CPU time (user and system ticks, not idle ones) is
+//	added up, whenever it stops running, as its virtual runtime,
+//	scaled by its priority's weight: a thread of twice the weight
+//	accumulates half the virtual runtime for the same ticks, and so
+//	gets twice the share.  A thread that has been blocked starts
+//	again no more than FairSleeperCredit virtual ticks behind the
+//	others, so that it cannot then monopolize the CPU.
+//
+//	The ready threads are kept in a balanced tree ordered by virtual
+//	runtime, so choosing, adding and removing one take O(log n).
+//----------------------------------------------------------------------
+
+void
+Scheduler::SetFair()
+{
+    ASSERT(HighestReady() < 0);		// nothing queued the other way
+    fair = TRUE;
+    fairTree = new AVLTree();
+    currentThread->runStart = stats->userTicks + stats->systemTicks;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Charge
+// 	Add the CPU time "thread" has had since it was last charged to
+//	its virtual runtime, weighted by its priority.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Charge(Thread *thread)
+{
+    int now = stats->userTicks + stats->systemTicks;
+    int ticks = now - thread->runStart;
+    int w = weight[thread->getPriority()];
+    int least;
+
+    thread->vruntime += (ticks / w) * FairNormalWeight
+                        + (ticks % w) * FairNormalWeight / w;
+    thread->runStart = now;
+
+    least = thread->vruntime;
+    if ((fairTree->First(&least) != NULL) && (least > thread->vruntime))
+    {
+        least = thread->vruntime;
+    }
+    if (least > minVruntime)
+    {
+        minVruntime = least;
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ShouldPreempt
+// 	Called when currentThread's time slice is up: should it yield to
+//	"next", the best ready thread?  Normally, if "next" has at least
+//	its priority; with fair scheduling, if "next" has had less CPU
+//	time (counting what currentThread has had so far).
+//----------------------------------------------------------------------
+
+bool
+Scheduler::ShouldPreempt(Thread *next)
+{
+    if (next->isPeriodic() || currentThread->isPeriodic())
+    {
+        return EarlierDeadline(next, currentThread);
+    }
+    if (!fair)
+    {
+        return next->getPriority() <= currentThread->getPriority();
+    }
+    Charge(currentThread);
+    return next->vruntime < currentThread->vruntime;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::AdmitPeriodic
+// 	Make "thread" periodic (see Thread::SetPeriodic), if it and the
+//	periodic threads already admitted can all meet their deadlines;
+//	return FALSE, changing nothing, if not.
+//
+//	Each needs "budget" ticks out of every min("period", "deadline"),
+//	and earliest deadline first meets every deadline as long as those
+//	fractions add up to no more than the whole CPU.  (Only sufficient
+//	when deadlines are shorter than periods, but safe.)  Ticks taken
+//	by interrupt handlers and other threads' critical sections are not
+//	accounted for.
+//
+//	A thread that is already periodic may be given new parameters;
+//	its first job under them is released now.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::AdmitPeriodic(Thread *thread, int period, int budget,
+                         int deadline)
+{
+    if ((period <= 0) || (budget <= 0) || (deadline <= 0)
+            || (budget > min(period, deadline)))
+    {
+        return FALSE;
+    }
+    double density = (double) budget / min(period, deadline);
+    double others = totalDensity;
+
+    if (thread->isPeriodic())
+    {
+        others -= (double) thread->budget
+                    / min(thread->period, thread->relativeDeadline);
+    }
+    if (others + density > 1.0)
+    {
+        DEBUG('t', "Not admitting thread %s: CPU %.2f taken, needs %.2f\n",
+                thread->getName(), others, density);
+        return FALSE;
+    }
+
+    bool ready = (thread->getStatus() == READY);
+
+    if (ready)
+    {
+        Dequeue(thread, thread->getPriority()); // from its old place
+    }
+    totalDensity = others + density;
+    thread->period = period;
+    thread->budget = budget;
+    thread->relativeDeadline = deadline;
+    thread->release = stats->totalTicks;
+    thread->deadline = thread->release + deadline;
+    stats->numRealTimeJobs++;
+    DEBUG('t', "Admitting thread %s: period %d, budget %d, deadline %d\n",
+            thread->getName(), period, budget, deadline);
+    if (ready)
+    {
+        Enqueue(thread);
+    }
+    UpdateTimer();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::EndPeriodic
+// 	"thread", which is periodic and running, is finishing: give back
+//	its share of the CPU to admission control.
+//----------------------------------------------------------------------
+
+void
+Scheduler::EndPeriodic(Thread *thread)
+{
+    totalDensity -= (double) thread->budget
+                        / min(thread->period, thread->relativeDeadline);
+    if (totalDensity < 0.0)
+    {
+        totalDensity = 0.0;             // rounding
+    }
+    thread->period = 0;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::WaitForRelease
+// 	The current job of "thread" (the running, periodic thread) is
+//	done.  If its next job is already due, release it, and return
+//	FALSE; the thread runs it, once any job with an earlier deadline
+//	has.  Otherwise, set an alarm to release it, and return TRUE; the
+//	thread should sleep until then.
+//----------------------------------------------------------------------
+
+static void
+ReleaseHandler(int arg)
+{
+    scheduler->Release((Thread *) arg);
+}
+
+bool
+Scheduler::WaitForRelease(Thread *thread)
+{
+    thread->release += thread->period;
+    if (thread->release <= stats->totalTicks)
+    {
+        thread->deadline = thread->release + thread->relativeDeadline;
+        stats->numRealTimeJobs++;
+
+        Thread *next = PickNextToRun();
+
+        if ((next != NULL) && EarlierDeadline(next, thread))
+        {
+            thread->Yield();            // it is now behind that one
+        }
+        return FALSE;
+    }
+    timer->SetAlarm(thread->release - stats->totalTicks, ReleaseHandler,
+                    (int) thread);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Release
+// 	Called from the alarm interrupt: the next job of periodic
+//	"thread" is due.  Make it ready, and preempt the running thread
+//	if the job's deadline is earlier.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Release(Thread *thread)
+{
+    thread->deadline = thread->release + thread->relativeDeadline;
+    stats->numRealTimeJobs++;
+    DEBUG('t', "Releasing a job of thread %s, deadline %d\n",
+            thread->getName(), thread->deadline);
+    ReadyToRun(thread);
+    if ((interrupt->getStatus() != IdleMode)
+            && EarlierDeadline(thread, currentThread))
+    {
+        interrupt->YieldOnReturn();
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::EarlierDeadline
+// 	Should "a" run before "b"?  A periodic thread runs before any
+//	other, and of two periodic threads, the one with the earlier
+//	deadline runs first.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::EarlierDeadline(Thread *a, Thread *b)
+{
+    if (!a->isPeriodic())
+    {
+        return FALSE;
+    }
+    return !b->isPeriodic() || (a->deadline < b->deadline);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Enqueue
+// 	Append "thread" to the queue for its priority, and mark the
+//	queue as not empty.  With fair scheduling, put it in the tree by
+//	its virtual runtime instead.  A periodic thread goes in the tree
+//	of them, by its deadline.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Enqueue(Thread *thread)
+{
+    int p = thread->getPriority();
+
+    if (thread->isPeriodic())
+    {
+        thread->edfTicket = edfTree->Insert(thread, thread->deadline);
+        return;
+    }
+    if (fair)
+    {
+        if (thread->vruntime < minVruntime - FairSleeperCredit)
+        {
+            thread->vruntime = minVruntime - FairSleeperCredit;
+        }
+        thread->fairTicket = fairTree->Insert(thread, thread->vruntime);
+        return;
+    }
+
+    thread->readyNext = NULL;
+    thread->readyPrev = readyTail[p];
+    if (readyTail[p] == NULL)
+    {
+        readyHead[p] = thread;
+        readyMask[p / 32] |= (unsigned) 1 << (p % 32);
+    }
+    else
+    {
+        readyTail[p]->readyNext = thread;
+    }
+    readyTail[p] = thread;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Dequeue
+// 	Unlink "thread" from the queue for priority "p", wherever it is
+//	on it, and mark the queue empty if it was the last one.  "p" is
+//	the priority it was queued at, which is not its priority if that
+//	has just changed.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Dequeue(Thread *thread, int p)
+{
+    if (thread->isPeriodic())
+    {
+        void *removed = edfTree->Remove(thread->deadline, thread->edfTicket);
+        ASSERT(removed == (void *) thread);
+        return;
+    }
+    if (fair)
+    {
+        void *removed = fairTree->Remove(thread->vruntime, 
+                                         thread->fairTicket);
+        ASSERT(removed == (void *) thread);
+        return;
+    }
+    if (thread->readyPrev == NULL)
+    {
+        ASSERT(readyHead[p] == thread);
+        readyHead[p] = thread->readyNext;
+    }
+    else
+    {
+        thread->readyPrev->readyNext = thread->readyNext;
+    }
+    if (thread->readyNext == NULL)
+    {
+        readyTail[p] = thread->readyPrev;
+    }
+    else
+    {
+        thread->readyNext->readyPrev = thread->readyPrev;
+    }
+    thread->readyNext = thread->readyPrev = NULL;
+    if (readyHead[p] == NULL)
+    {
+        readyMask[p / 32] &= ~((unsigned) 1 << (p % 32));
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::HighestReady
+// 	Return the best (lowest numbered) priority that has a thread
+//	ready to run, or -1 if none has.
+//----------------------------------------------------------------------
+
+int
+Scheduler::HighestReady()
+{
+    for (int i = 0; i < ReadyMaskWords; ++i)
+    {
+        if (readyMask[i] != 0)
+        {
+            return i * 32 + ffs(readyMask[i]) - 1;
+        }
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SetTickless
+// 	Stop the timer whenever its interrupt could not switch threads:
+//	when nothing is ready to run, or (unless "yieldToAny", or with
+//	fair scheduling or multilevel feedback) only threads of lower
+//	priority than the running one.  The timer is started again as
+//	soon as a time slice matters, so a lone thread or an idle system
+//	takes no timer interrupts at all.
+//
+//	"yieldToAny" -- TRUE if the timer handler yields to any ready
+//		thread (-rs), FALSE if only to one of equal or higher 
+//		priority
+//----------------------------------------------------------------------
+
+void
+Scheduler::SetTickless(bool yieldToAny)
+{
+    tickless = TRUE;
+    anyReadyPreempts = yieldToAny;
+    UpdateTimer();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::UpdateTimer
+// 	In tickless mode, start or stop the timer according to whether
+//	a time slice could switch threads now.  Called whenever the
+//	ready lists or the running thread change.
+//----------------------------------------------------------------------
+
+void
+Scheduler::UpdateTimer()
+{
+    if (!tickless || (timer == NULL))
+        return;
+
+    Thread *next = PickNextToRun();
+    bool needed;
+
+    if ((next == NULL) || currentThread->isPeriodic())
+    {
+        needed = FALSE;         // no time slices: it runs until its job
+                                // is done or an earlier deadline comes
+    }
+    else
+    {
+        // multilevel feedback demotes and ages threads from the timer
+        // handler, so it must keep running while anything is ready
+        needed = anyReadyPreempts || fair || mlfq || next->isPeriodic() ||
+                (next->getPriority() <= currentThread->getPriority());
+    }
+
+    if (needed)
+        timer->Start();
+    else
+        timer->Stop();
 }
 
 //----------------------------------------------------------------------
@@ -72,9 +636,13 @@ void
 Scheduler::ReadyToRun (Thread *thread)
 {
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
-    List *readyList = readyLists[thread->getPriority()];
+    if (fair && (thread == currentThread))
+    {
+        Charge(thread);                 // before it is put in the tree
+    }
     thread->setStatus(READY);
-    readyList->Append((void *)thread);
+    Enqueue(thread);
+    UpdateTimer();
 }
 
 //----------------------------------------------------------------------
@@ -88,16 +656,14 @@ Scheduler::ReadyToRun (Thread *thread)
 Thread *
 Scheduler::FindNextToRun ()
 {
+    Thread *thread = PickNextToRun();
 
-    for (int i = 0; i < MaxThreadPriority; ++i)
+    if (thread != NULL)
     {
-        List *readyList = readyLists[i];
-        if (readyList->IsEmpty())
-        {
-            continue;
-        }
-        return (Thread *)readyList->Remove();
-    }   
+        Dequeue(thread, thread->getPriority());
+        return thread;
+    }
+    UpdateTimer();                      // nothing to run: no time slices
     return NULL;
 }
 
@@ -108,16 +674,21 @@ Scheduler::FindNextToRun ()
 //----------------------------------------------------------------------
 Thread *
 Scheduler::PickNextToRun () {
-    for (int i = 0; i < MaxThreadPriority; ++i)
+    if (!edfTree->IsEmpty())
     {
-        List *readyList = readyLists[i];
-        if (readyList->IsEmpty())
-        {
-            continue;
-        }
-        return (Thread *)(readyList->First()->item);
-    }   
-    return NULL;
+        int deadline;
+
+        return (Thread *) edfTree->First(&deadline);
+    }
+    if (fair)
+    {
+        int vruntime;
+
+        return (Thread *) fairTree->First(&vruntime);
+    }
+    int p = HighestReady();
+
+    return (p >= 0) ? readyHead[p] : NULL;
 }
 
 //----------------------------------------------------------------------
@@ -148,9 +719,14 @@ Scheduler::Run (Thread *nextThread)
     
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
+    if (fair) {
+        Charge(oldThread);		    // for the CPU time it has had,
+        nextThread->runStart = oldThread->runStart; // and from now, next
+    }
 
     currentThread = nextThread;		    // switch to the next thread
     currentThread->setStatus(RUNNING);      // nextThread is now running
+    UpdateTimer();			    // does it need time slices?
     
     DEBUG('t', "Switching from thread \"%s\" to thread \"%s\"\n",
 	  oldThread->getName(), nextThread->getName());
@@ -189,11 +765,30 @@ Scheduler::Run (Thread *nextThread)
 void
 Scheduler::Print()
 {
+    if (!edfTree->IsEmpty())
+    {
+        printf("Ready periodic threads, by deadline:\n");
+        edfTree->Mapcar((VoidFunctionPtr) ThreadPrint);
+        printf("\n");
+    }
+    if (fair)
+    {
+        printf("Ready threads, by virtual runtime:\n");
+        fairTree->Mapcar((VoidFunctionPtr) ThreadPrint);
+        printf("\n");
+        return;
+    }
     for (int i = 0; i < MaxThreadPriority; ++i)
     {
+        if (readyHead[i] == NULL)
+        {
+            continue;
+        }
         printf("Ready list [ %d ] contents:\n", i);
-        List *readyList = readyLists[i];
-        readyList->Mapcar((VoidFunctionPtr) ThreadPrint);
+        for (Thread *t = readyHead[i]; t != NULL; t = t->readyNext)
+        {
+            ThreadPrint((int) t);
+        }
         printf("\n");
     } 
 }
@@ -12,11 +12,24 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include "avltree.h"
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
 
+#define ReadyMaskWords	divRoundUp(MaxThreadPriority, 32)
+
+// Multilevel feedback (see Scheduler::SetMlfq)
+#define MlfqStep	8	// priorities a thread is demoted or boosted by
+#define MlfqAgingTime	5000	// ticks between raising every thread back
+				// to its base priority
+
+// Completely fair scheduling (see Scheduler::SetFair)
+#define FairNormalWeight 1024	// weight of a NormalThreadPriority thread
+#define FairSleeperCredit 100	// how far (in virtual ticks) behind the 
+				// ready threads a waking thread may start
+
 class Scheduler {
   public:
     Scheduler();			// Initialize list of ready threads 
@@ -25,14 +38,66 @@ class Scheduler {
     void ReadyToRun(Thread* thread);	// Thread can be dispatched.
     Thread* FindNextToRun();		// Dequeue first thread on the ready 
 					// list, if any, and return thread.
-    Thread* PickNextToRun(); 
+    Thread* PickNextToRun(); 		// Same, but leave it on the list
     void Run(Thread* nextThread);	// Cause nextThread to start running
     void Print();			// Print contents of ready list
     void priorityChanged(Thread* aThread,int oldPriority); // call when change thread priority
+    void SetTickless(bool yieldToAny);	// Run the timer only when a time
+					// slice could switch threads
+    void UpdateTimer();			// Start or stop it to match
+
+    void SetMlfq();			// Adjust priorities by behavior:
+    int Quantum(int priority);		// timer interrupts per time slice
+    void QuantumUsed(Thread *thread);	// demote a thread that used one up
+    void IOWait(Thread *thread);	// boost one about to wait for I/O
+    void Age();				// periodically, undo it all
+    bool IsMlfq() { return mlfq; }	// is multilevel feedback on?
+
+    void SetFair();			// Share the CPU by virtual runtime
+    bool ShouldPreempt(Thread *next);	// Would a time slice switch from
+					// currentThread to "next"?
+    bool IsFair() { return fair; }	// is fair scheduling on?
+    int MinVruntime() { return minVruntime; } // least virtual runtime
+
+    // periodic threads, run earliest deadline first, before all others
+    bool AdmitPeriodic(Thread *thread, int period, int budget,
+			int deadline);	// can it meet its deadlines?
+    void EndPeriodic(Thread *thread);	// it no longer needs its share
+    bool WaitForRelease(Thread *thread);// its job is done; wait for the
+					// next one?
+    void Release(Thread *thread);	// the next one is due: run it
   private:
-    // queue of threads that are ready to run,
-		// but not running
-    List *readyLists[MaxThreadPriority]; // array of ready list, different priority
+    bool tickless;			// is the timer started on demand?
+    bool anyReadyPreempts;		// does the timer handler yield to any
+					// ready thread, or only to one of
+					// equal or higher priority?
+    bool mlfq;				// multilevel feedback on?
+    int nextAging;			// when Age next raises everyone
+    bool fair;				// completely fair scheduling on?
+    AVLTree *fairTree;			// if so, the ready threads, ordered
+					// by virtual runtime
+    int minVruntime;			// the least virtual runtime of any
+					// ready or running thread; never
+					// goes down
+    int weight[MaxThreadPriority];	// CPU share of each priority
+    AVLTree *edfTree;			// ready periodic threads, ordered
+					// by deadline
+    double totalDensity;		// CPU share the periodic threads
+					// have been promised
+    // queues of threads that are ready to run, but not running, one
+    // per priority, linked through the threads (readyNext, readyPrev)
+    Thread *readyHead[MaxThreadPriority];
+    Thread *readyTail[MaxThreadPriority];
+    unsigned int readyMask[ReadyMaskWords]; // bit p set: queue p not empty
+
+    void Enqueue(Thread *thread);	// append to its priority's queue
+    void Dequeue(Thread *thread, int p);// take off queue p, from anywhere
+    int HighestReady();			// best priority with a ready thread,
+					// or -1
+    bool EarlierDeadline(Thread *a, Thread *b); // should "a" run before
+					// "b", by the periodic threads' rule?
+    void Charge(Thread *thread);	// add its CPU time to its virtual
+					// runtime
 };
 
 #endif // SCHEDULER_H
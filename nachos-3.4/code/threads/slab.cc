@@ -0,0 +1,146 @@
+// slab.cc
+//	Routines to allocate small kernel objects from slab caches.
+//	See slab.h.
+
+#include "copyright.h"
+#include "slab.h"
+
+SlabCache *SlabCache::allCaches = NULL;
+
+// Objects are aligned (and so rounded up) to this many bytes, enough
+// for any type the kernel puts in them
+#define SlabAlign	8
+
+//----------------------------------------------------------------------
+// SlabCache::SlabCache
+// 	Initialize an empty cache; its first Alloc allocates a slab.
+//
+//	"cacheName" -- what to call the cache in the statistics
+//	"size" -- how many bytes each object needs
+//	"perSlab" -- how many objects to allocate from the host at once
+//----------------------------------------------------------------------
+
+SlabCache::SlabCache(char *cacheName, int size, int perSlab)
+{
+    ASSERT((size > 0) && (perSlab > 0));
+    name = cacheName;
+    objectSize = divRoundUp(size, SlabAlign) * SlabAlign;
+    objectsPerSlab = perSlab;
+    slabs = NULL;
+    freeList = NULL;
+    numSlabs = inUse = maxInUse = numAllocs = 0;
+    nextCache = allCaches;
+    allCaches = this;
+}
+
+//----------------------------------------------------------------------
+// SlabCache::~SlabCache
+// 	Give the slabs back to the host.  Any objects still in use go
+//	with them.
+//----------------------------------------------------------------------
+
+SlabCache::~SlabCache()
+{
+    while (slabs != NULL) {
+	char *slab = slabs;
+
+	slabs = *(char **) slab;
+	delete [] slab;
+    }
+    for (SlabCache **c = &allCaches; *c != NULL; c = &(*c)->nextCache)
+	if (*c == this) {
+	    *c = nextCache;
+	    break;
+	}
+}
+
+//----------------------------------------------------------------------
+// SlabCache::Grow
+// 	Allocate another slab from the host, and put its objects on the
+//	free list.  The first SlabAlign bytes of the slab chain it to
+//	the others, so that they can be given back.
+//----------------------------------------------------------------------
+
+void
+SlabCache::Grow()
+{
+    char *slab = new char[SlabAlign + objectsPerSlab * objectSize];
+
+    *(char **) slab = slabs;
+    slabs = slab;
+    numSlabs++;
+    for (int i = objectsPerSlab - 1; i >= 0; i--) {
+	void **object = (void **) (slab + SlabAlign + i * objectSize);
+
+	*object = freeList;
+	freeList = (void *) object;
+    }
+    DEBUG('k', "Slab cache \"%s\" grows to %d slabs of %d %d-byte objects\n",
+		name, numSlabs, objectsPerSlab, objectSize);
+}
+
+//----------------------------------------------------------------------
+// SlabCache::Alloc
+// 	Take an object off the free list, growing the cache if the
+//	list is empty.
+//
+//	"size" -- the bytes wanted (as passed to operator new); no more
+//		than the cache's object size
+//----------------------------------------------------------------------
+
+void *
+SlabCache::Alloc(int size)
+{
+    void *object;
+
+    ASSERT(size <= objectSize);
+    if (freeList == NULL)
+	Grow();
+    object = freeList;
+    freeList = *(void **) object;
+    numAllocs++;
+    if (++inUse > maxInUse)
+	maxInUse = inUse;
+    return object;
+}
+
+//----------------------------------------------------------------------
+// SlabCache::Free
+// 	Put "object" back on the free list.  Like delete, freeing NULL
+//	does nothing.
+//----------------------------------------------------------------------
+
+void
+SlabCache::Free(void *object)
+{
+    if (object == NULL)
+	return;
+    ASSERT(inUse > 0);
+    *(void **) object = freeList;
+    freeList = object;
+    inUse--;
+}
+
+//----------------------------------------------------------------------
+// SlabCache::Print, SlabCache::PrintAll
+// 	Print how many objects were allocated from a cache, how many
+//	were in use at most, and how much host memory it took.
+//----------------------------------------------------------------------
+
+void
+SlabCache::Print()
+{
+    printf("%-20s %6d %10d %8d %8d %8d\n", name, objectSize, numAllocs,
+		inUse, maxInUse,
+		numSlabs * (SlabAlign + objectsPerSlab * objectSize));
+}
+
+void
+SlabCache::PrintAll()
+{
+    printf("\nSlab caches:\n%-20s %6s %10s %8s %8s %8s\n", "cache", "size",
+		"allocs", "in use", "peak", "bytes");
+    for (SlabCache *c = allCaches; c != NULL; c = c->nextCache)
+	if (c->numAllocs > 0)
+	    c->Print();
+}
@@ -0,0 +1,63 @@
+// slab.h
+//	Data structures for caches of small, fixed-size kernel objects.
+//
+//	A slab cache hands out objects of one size from slabs -- arrays
+//	of many objects, allocated from the host all at once.  A freed
+//	object goes on the cache's free list, and is handed out again by
+//	the next Alloc, so that a kernel path that allocates and frees the
+//	same kind of object over and over (list elements, pending
+//	interrupts, disk buffers) stops calling the host's malloc once
+//	the cache has grown to fit it.  Slabs are never given back.
+//
+//	A class uses a cache by declaring operator new and delete, and
+//	defining them (next to the cache) to call Alloc and Free:
+//
+//	    static SlabCache elementCache("list element", sizeof(ListElement));
+//
+//	    void *ListElement::operator new(size_t size)
+//	    { return elementCache.Alloc(size); }
+//	    void ListElement::operator delete(void *p)
+//	    { elementCache.Free(p); }
+//
+//	Caches are usually static objects; nothing may be allocated from
+//	one before the host has run its constructor.
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define SlabObjects	32	// objects per slab, unless told otherwise
+
+class SlabCache {
+  public:
+    SlabCache(char *cacheName, int size, int perSlab = SlabObjects);
+				// a cache of "size" byte objects
+    ~SlabCache();
+
+    void *Alloc(int size);	// Return a free object of at most
+				// "size" bytes (the cache's size)
+    void Free(void *object);	// Give "object" back to the cache
+
+    void Print();		// Print how much the cache was used
+    static void PrintAll();	// ... for every cache that was
+
+  private:
+    void Grow();		// Add a slab to the free list
+
+    char *name;			// for the statistics
+    int objectSize;		// bytes per object, rounded up to align
+    int objectsPerSlab;
+    char *slabs;		// every slab, chained through its
+				// first word
+    void *freeList;		// free objects, chained through theirs
+    int numSlabs;
+    int inUse;			// objects handed out and not yet freed
+    int maxInUse;		// the most ever in use at once
+    int numAllocs;		// calls to Alloc
+    SlabCache *nextCache;	// on the list of every cache
+    static SlabCache *allCaches;
+};
+
+#endif // SLAB_H
@@ -100,8 +100,9 @@ Semaphore::V()
 Lock::Lock(char* debugName) 
 {
     name = debugName;
-    owner = currentThread;
+    owner = NULL;
     lockSem = new Semaphore("lock semaphore", 1);
+    nextHeld = NULL;
 }
 
 Lock::~Lock() 
@@ -109,23 +110,164 @@ Lock::~Lock()
     delete lockSem;
 }
 
+//----------------------------------------------------------------------
+// Lock::Acquire
+// 	Wait until the lock is FREE, then take it.  While we wait, the
+//	owner inherits our priority (see Lock::Reinherit).
+//----------------------------------------------------------------------
+
 void Lock::Acquire() 
 {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    if (owner != NULL)
+    {
+        currentThread->waitingFor = this;
+        Reinherit(owner);               // lend the owner our priority
+    }
     lockSem->P();
-    owner = currentThread;
+    currentThread->waitingFor = NULL;
+    Own(currentThread);
     DEBUG('t', "Lock %s - Change owner to %s\n", name, currentThread->getName());
     (void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Lock::Release
+// 	Set the lock FREE, giving back any priority we inherited through
+//	it, and wake up a waiter.  If giving it back leaves a thread of
+//	better priority ready (the waiter, usually), let it run -- unless
+//	the caller has interrupts off, and so counts on keeping the CPU
+//	(as Condition::Wait does, until it sleeps).
+//----------------------------------------------------------------------
+
 void Lock::Release() 
 {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
     ASSERT(isHeldByCurrentThread())
+    int oldPriority = currentThread->getPriority();
+
+    Disown();
     lockSem->V();
+
+    Thread *next = scheduler->PickNextToRun();
+
+    if ((oldLevel == IntOn) && (currentThread->getPriority() > oldPriority)
+            && (next != NULL)
+            && (next->getPriority() < currentThread->getPriority()))
+    {
+        currentThread->Yield();
+    }
     (void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Lock::setOwner
+// 	Make "newOwner" the owner of the held lock, as if it had been the
+//	one to acquire it.  The old owner gives back any priority it
+//	inherited through the lock, and the new one inherits it instead.
+//	A NULL "newOwner" leaves the lock busy with no owner, as when its
+//	owner finishes without releasing it (see Thread::Finish).
+//----------------------------------------------------------------------
+
+void Lock::setOwner(Thread* newOwner)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    if (owner != NULL)
+    {
+        Disown();
+    }
+    if (newOwner != NULL)
+    {
+        Own(newOwner);
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Lock::Own, Lock::Disown
+// 	Add the lock to the locks "thread" holds, and have it inherit
+//	from anyone still waiting; or take the lock off the owner's, and
+//	have the owner give back what it inherited through it.
+//----------------------------------------------------------------------
+
+void Lock::Own(Thread *thread)
+{
+    owner = thread;
+    nextHeld = thread->locksHeld;
+    thread->locksHeld = this;
+    Reinherit(thread);
+}
+
+void Lock::Disown()
+{
+    Thread *oldOwner = owner;
+    Lock **l;
+
+    for (l = &oldOwner->locksHeld; *l != this; l = &(*l)->nextHeld)
+    {
+        ASSERT(*l != NULL);
+    }
+    *l = nextHeld;
+    nextHeld = NULL;
+    owner = NULL;
+    Reinherit(oldOwner);
+}
+
+//----------------------------------------------------------------------
+// Lock::BestWaiter
+// 	Return the best priority of any thread waiting for the lock, or
+//	MaxThreadPriority if none is.  The waiters are found through the
+//	thread table, as the semaphore's queue is its own.
+//----------------------------------------------------------------------
+
+int Lock::BestWaiter()
+{
+    int best = MaxThreadPriority;
+
+    for (int pid = 0; pid < MaxProcessNum; ++pid)
+    {
+        Thread *t = Thread::GetThread(pid);
+
+        if ((t != NULL) && (t->waitingFor == this))
+        {
+            best = min(best, t->getPriority());
+        }
+    }
+    return best;
+}
+
+//----------------------------------------------------------------------
+// Lock::Reinherit
+// 	Set the priority "thread" inherits to the best priority waiting
+//	for any lock it holds.  If that changes its priority, and it is
+//	itself waiting for a lock, pass the change on to that lock's
+//	owner, and so on down the chain.  (A deadlocked cycle stops once
+//	every thread on it has the same priority.)
+//----------------------------------------------------------------------
+
+void Lock::Reinherit(Thread *thread)
+{
+    while (thread != NULL)
+    {
+        int oldPriority = thread->getPriority();
+        int best = MaxThreadPriority;
+
+        for (Lock *l = thread->locksHeld; l != NULL; l = l->nextHeld)
+        {
+            best = min(best, l->BestWaiter());
+        }
+        thread->inheritPriority(best);
+        if ((thread->getPriority() == oldPriority) 
+                || (thread->waitingFor == NULL))
+        {
+            return;
+        }
+        DEBUG('t', "Thread %s now runs at priority %d\n", 
+                thread->getName(), thread->getPriority());
+        thread = thread->waitingFor->owner;
+    }
+}
+
 bool Lock::isHeldByCurrentThread()
 {
     return currentThread == owner;
@@ -147,8 +289,8 @@ void Condition::Wait(Lock* conditionLock)
 {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
     ASSERT(conditionLock->isHeldByCurrentThread());
+    waiting ++;                   // counted before anyone can Signal
     conditionLock->Release();     //releasing the lock and
-    waiting ++;
     conSem->P();                  // going to sleep until csignal / broadcast
     conditionLock -> Acquire();   // then re-acquire the lock
     (void) interrupt->SetLevel(oldLevel);
@@ -64,6 +64,12 @@ class Semaphore {
 // In addition, by convention, only the thread that acquired the lock
 // may release it.  As with semaphores, you can't read the lock value
 // (because the value might change immediately after you read it).  
+//
+// Locks use priority inheritance: while a thread waits in Acquire, the
+// thread holding the lock runs at (at least) the waiter's priority,
+// and so on down the chain if that one is waiting for another lock,
+// so that a high priority thread is not kept waiting by threads of
+// medium priority that happen to be ready.
 
 class Lock {
   public:
@@ -79,15 +85,21 @@ class Lock {
 					// checking in Release, and in
 					// Condition variable ops below.
     
-    void setOwner(Thread* newOwner) { 
-        owner = newOwner; 
-    } // need by RWLock
+    void setOwner(Thread* newOwner);	// hand the lock over; needed
+					// by RWLock
 
   private:
     char* name;				// for debugging
     // plus some other stuff you'll need to define
-    Thread* owner;
+    Thread* owner;			// NULL if FREE
     Semaphore *lockSem;
+    Lock *nextHeld;			// the owner's next lock
+
+    void Own(Thread *thread);		// make "thread" the owner
+    void Disown();			// make it FREE
+    int BestWaiter();			// best priority waiting for it
+    static void Reinherit(Thread *thread); // recompute what "thread"
+					// inherits, and pass it on
 };
 
 // The following class defines a "condition variable".  A condition
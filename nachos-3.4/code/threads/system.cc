@@ -7,6 +7,13 @@
 
 #include "copyright.h"
 #include "system.h"
+#ifdef USER_PROGRAM
+#include "profile.h"
+#include "cache.h"
+#include "trace.h"
+#include "costmodel.h"
+#include "checkpoint.h"
+#endif
 
 // This defines *all* of the global data structures used by Nachos.
 // These are all initialized and de-allocated by this file.
@@ -31,6 +38,7 @@ SynchDisk   *synchDisk;
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
 Machine *machine;	// user program memory and registers
 PageManager *pageManager; // inverted page table manager
+char *restoreFile = NULL;	// checkpoint to start -x from, if any
 #endif
 
 #ifdef NETWORK
@@ -69,16 +77,18 @@ TimerInterruptHandler(int dummy)
 static void
 TimerInterruptHandlerThread(int dummy)
 {
+    scheduler->Age();                   // (multilevel feedback only)
     if (interrupt->getStatus() != IdleMode) {
         currentThread->increaseTimerTick();
         if (currentThread->getTimerTick() > currentThread->maxTimerTick())
         {
+             scheduler->QuantumUsed(currentThread); // may demote it
              Thread* nextThread = scheduler-> PickNextToRun();
             // Check if current thread' priority is higher or not exist
             if ( nextThread == NULL) {
                 return;
             }
-            if ( nextThread->getPriority() > currentThread->getPriority() )
+            if ( !scheduler->ShouldPreempt(nextThread) )
             {
                 return;
             }
@@ -90,6 +100,19 @@ TimerInterruptHandlerThread(int dummy)
     } 
 }
 
+#ifdef USER_PROGRAM
+//----------------------------------------------------------------------
+// FastForwardHandler
+// 	Interrupt handler that ends the fast-forward phase at the time
+//	given to -ff.
+//----------------------------------------------------------------------
+static void
+FastForwardHandler(int dummy)
+{
+    machine->StartTiming();
+}
+#endif
+
 //----------------------------------------------------------------------
 // Initialize
 // 	Initialize Nachos global data structures.  Interpret command
@@ -106,9 +129,25 @@ Initialize(int argc, char **argv)
     int argCount;
     char* debugArgs = "";
     bool randomYield = FALSE;
+    bool tickless = FALSE;
+    bool mlfq = FALSE;
+    bool fair = FALSE;
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
+    ExecEngine engine = InterpEngine;	// how to execute user instructions
+    bool tagTLB = FALSE;	// keep TLB entries across context switches
+    bool walkTables = FALSE;	// refill the TLB in hardware
+    char *profileFile = NULL;	// COFF file of the program to profile
+    char *traceFile = NULL;	// where to record an instruction trace
+    char *costFile = NULL;	// ticks for each class of instruction
+    int fastForward = -1;	// ticks to fast-forward, 0 = until the
+				// StartTiming system call, -1 = none
+    int fastForwardInstructions = 0; // or user instructions
+    int l1[3] = { 0, 0, 0 };	// size, ways, line size of each L1 cache
+    int l2[3] = { 0, 0, 0 };	// and of the L2 cache; size 0 = none
+    char *checkpointFile = NULL;	// where to save a checkpoint
+    int checkpointTime = 0;		// and when
 #endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
@@ -133,10 +172,76 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
-	}
+	} else if (!strcmp(*argv, "-tickless"))
+	    tickless = TRUE;
+	else if (!strcmp(*argv, "-mlfq"))
+	    mlfq = TRUE;
+	else if (!strcmp(*argv, "-cfs"))
+	    fair = TRUE;
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
+	else if (!strcmp(*argv, "-bb"))
+	    engine = BlockEngine;
+	else if (!strcmp(*argv, "-jit"))
+	    engine = JitEngine;
+	else if (!strcmp(*argv, "-pages")) {
+	    ASSERT(argc > 1);
+	    numPhysPages = atoi(*(argv + 1));	// size of physical memory
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-pagesize")) {
+	    ASSERT(argc > 1);
+	    pageSize = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-tlb")) {
+	    ASSERT(argc > 1);
+	    tlbSize = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-tlbways")) {
+	    ASSERT(argc > 1);
+	    tlbWays = atoi(*(argv + 1));	// TLB set associativity
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-asid"))
+	    tagTLB = TRUE;
+	else if (!strcmp(*argv, "-walk"))
+	    walkTables = TRUE;
+	else if (!strcmp(*argv, "-prof")) {
+	    ASSERT(argc > 1);
+	    profileFile = *(argv + 1);		// for the procedure names
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-ff")) {
+	    ASSERT(argc > 1);
+	    fastForward = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-ffi")) {
+	    ASSERT(argc > 1);
+	    fastForwardInstructions = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-cost")) {
+	    ASSERT(argc > 1);
+	    costFile = *(argv + 1);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-trace")) {
+	    ASSERT(argc > 1);
+	    traceFile = *(argv + 1);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-l1") || !strcmp(*argv, "-l2")) {
+	    int *geometry = (*argv)[2] == '1' ? l1 : l2;
+
+	    ASSERT(argc > 3);
+	    for (int i = 0; i < 3; i++)
+		geometry[i] = atoi(*(argv + 1 + i));
+	    argCount = 4;
+	} else if (!strcmp(*argv, "-save")) {
+	    ASSERT(argc > 2);
+	    checkpointFile = *(argv + 1);
+	    checkpointTime = atoi(*(argv + 2));
+	    argCount = 3;
+	} else if (!strcmp(*argv, "-restore")) {
+	    ASSERT(argc > 1);
+	    restoreFile = *(argv + 1);
+	    argCount = 2;
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
@@ -173,12 +278,40 @@ Initialize(int argc, char **argv)
     // object to save its state. 
     currentThread = new Thread("main");		
     currentThread->setStatus(RUNNING);
+    if (tickless)
+	scheduler->SetTickless(randomYield);	// timer only when needed
+    if (fair)
+	scheduler->SetFair();		// share the CPU by virtual runtime
+    else if (mlfq)
+	scheduler->SetMlfq();		// priorities follow behavior
 
     interrupt->Enable();
     CallOnUserAbort(Cleanup);			// if user hits ctl-C
     
 #ifdef USER_PROGRAM
-    machine = new Machine(debugUserProg);	// this must come first
+    machine = new Machine(debugUserProg, engine);	// this must come first
+    if (profileFile != NULL)
+	machine->profiler = new Profiler(profileFile);
+    if (traceFile != NULL)
+	machine->tracer = new TraceRecorder(traceFile);
+    if (costFile != NULL)
+	machine->costModel = new CostModel(costFile);
+    if (fastForwardInstructions > 0)
+	machine->StartFastForward(fastForwardInstructions);
+    else if (fastForward >= 0) {
+	machine->StartFastForward(0);
+	if (fastForward > 0)
+	    interrupt->Schedule(FastForwardHandler, 0, fastForward, 
+				FastForwardInt);
+    }
+    if (l1[0] > 0) {
+	if (l2[0] > 0)
+	    machine->l2cache = new Cache("L2", l2[0], l2[1], l2[2], NULL);
+	machine->icache = new Cache("L1 instruction", l1[0], l1[1], l1[2],
+				    machine->l2cache);
+	machine->dcache = new Cache("L1 data", l1[0], l1[1], l1[2],
+				    machine->l2cache);
+    }
    
 #endif
 
@@ -191,7 +324,9 @@ Initialize(int argc, char **argv)
     fileSystem = new FileSystem(format);
 #endif
 #ifdef USER_PROGRAM
- pageManager = new PageManager();
+ pageManager = new PageManager(tagTLB, walkTables);
+    if (checkpointFile != NULL)
+	ScheduleCheckpoint(checkpointFile, checkpointTime);
  #endif
 #ifdef NETWORK
     postOffice = new PostOffice(netname, rely, 10);
@@ -211,8 +346,8 @@ Cleanup()
 #endif
     
 #ifdef USER_PROGRAM
+    delete pageManager;			// may still clear machine->pageDirectory
     delete machine;
-    delete pageManager;
 #endif
 
 #ifdef FILESYS_NEEDED
@@ -36,6 +36,7 @@ extern Timer *timer;				// the hardware alarm clock
 
 extern Machine* machine;	// user program memory and registers
 extern PageManager *pageManager; // inverted page table for user threads
+extern char *restoreFile;	// checkpoint to start user programs from
 #endif
 
 #ifdef FILESYS_NEEDED 		// FILESYS or FILESYS_STUB 
@@ -48,8 +48,13 @@ Thread::Thread(char* threadName,int threadUid)
 
     threadTable[pid] = this;
 
-    priority = 1;
+    priority = basePriority = NormalThreadPriority;
+    inheritedPriority = MaxThreadPriority;
+    waitingFor = locksHeld = NULL;
     timerTick = 0;
+    readyNext = readyPrev = NULL;
+    vruntime = fairTicket = runStart = 0;
+    period = budget = relativeDeadline = deadline = release = edfTicket = 0;
 
     joinCondition = new Condition("Join condition");
     joinLock = new Lock("Join lock");
@@ -90,23 +95,58 @@ Thread::~Thread()
 //----------------------------------------------------------------------
 
 void Thread::setPriority(int prio) { 
-        if (prio > MaxThreadPriority || prio < 0)
+        if (prio >= MaxThreadPriority || prio < 0)
         {
              printf("Warning: Illigal priority for thread %s, ", name);
              return;
         }
-        if (prio == priority)
+        basePriority = prio;
+        adjustPriority(prio);
+    }
+
+//----------------------------------------------------------------------
+// Thread::adjustPriority
+// Change the priority the thread is scheduled at, but not its base
+// priority.  Used by the scheduler's feedback policy.
+//----------------------------------------------------------------------
+
+void Thread::adjustPriority(int prio) { 
+        ASSERT(prio >= 0 && prio < MaxThreadPriority);
+        int oldPriority = getPriority();
+        priority = prio; 
+        if ((status == READY) && (getPriority() != oldPriority))
         {
-            return;
+            scheduler->priorityChanged(this,oldPriority);
         }
-        int oldPriority = priority;
-        priority = prio; 
-        if (status == READY)
+    }
+
+//----------------------------------------------------------------------
+// Thread::inheritPriority
+// Lend the thread priority "prio" (if better than its own) for as long
+// as a thread of that priority waits for a lock it holds.  Used by
+// Lock; MaxThreadPriority takes back whatever was lent.
+//----------------------------------------------------------------------
+
+void Thread::inheritPriority(int prio) { 
+        ASSERT(prio >= 0 && prio <= MaxThreadPriority);
+        int oldPriority = getPriority();
+        inheritedPriority = prio; 
+        if ((status == READY) && (getPriority() != oldPriority))
         {
             scheduler->priorityChanged(this,oldPriority);
         }
     }
 
+//----------------------------------------------------------------------
+// Thread::maxTimerTick
+// How many timer interrupts the thread may run for before it should
+// yield: the scheduler's quantum for its priority.
+//----------------------------------------------------------------------
+
+int Thread::maxTimerTick() {
+        return scheduler->Quantum(priority);
+    }
+
 //----------------------------------------------------------------------
 // Thread::Fork
 // 	Invoke (*func)(arg), allowing caller and callee to execute 
@@ -140,7 +180,7 @@ Thread::Fork(VoidFunctionPtr func, int arg)
 					// are disabled!
     (void) interrupt->SetLevel(oldLevel);
     // high thread take possession
-    if (this->priority < currentThread->priority)
+    if (this->getPriority() < currentThread->getPriority())
     {
         currentThread->Yield(); 
     }
@@ -201,10 +241,18 @@ Thread::Finish ()
     }
     threadToBeDestroyed = currentThread;
     PidFree(pid);
+    if (isPeriodic())
+    {
+        scheduler->EndPeriodic(this);   // give back its CPU share
+    }
     if (joinCondition != NULL)
     {
        joinCondition->Broadcast(joinLock);
     }
+    while (locksHeld != NULL)           // e.g. an RWLock's, which the
+    {                                   // last reader out releases;
+        locksHeld->setOwner(NULL);      // they stay busy, but must not
+    }                                   // point back at us
     Sleep();					// invokes SWITCH
     // not reached
 }
@@ -401,6 +449,81 @@ Thread::PidFree(int aPid)
     threadTable[aPid] = NULL;
 }
 
+//======================================================================
+// number of threads that have not been destroyed
+//======================================================================
+int
+Thread::NumThreads()
+{
+    int n = 0;
+
+    for (int i = 0; i < MaxProcessNum; i++)
+        if (threadTable[i] != NULL)
+            n++;
+    return n;
+}
+
+//----------------------------------------------------------------------
+// Thread::SetPeriodic
+// Make the thread a periodic real-time thread: one job is released
+// now, and another every "period" ticks, each of which needs "budget"
+// ticks of CPU before "deadline" ticks after its release.  Such
+// threads are scheduled earliest deadline first, ahead of all others.
+// Each job should end with WaitForNextPeriod.
+//
+// Returns FALSE, and leaves the thread as it was, if the scheduler
+// cannot admit it (see Scheduler::AdmitPeriodic).  Can be called
+// before the thread is forked, or by the thread itself.
+//----------------------------------------------------------------------
+
+bool
+Thread::SetPeriodic(int newPeriod, int newBudget, int newDeadline)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    bool admitted = scheduler->AdmitPeriodic(this, newPeriod, newBudget,
+                                             newDeadline);
+
+    (void) interrupt->SetLevel(oldLevel);
+    return admitted;
+}
+
+//----------------------------------------------------------------------
+// Thread::WaitForNextPeriod
+// The current job of this periodic thread is done: count it as a
+// deadline miss if it finished late, and sleep until the next job
+// is released.
+//----------------------------------------------------------------------
+
+void
+Thread::WaitForNextPeriod()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(this == currentThread && isPeriodic());
+    if (stats->totalTicks > deadline)
+    {
+        DEBUG('t', "Thread %s missed its deadline %d by %d ticks\n",
+              name, deadline, stats->totalTicks - deadline);
+        stats->numDeadlineMisses++;
+    }
+    if (scheduler->WaitForRelease(this))
+    {
+        Sleep();                        // until Scheduler::Release
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//======================================================================
+// the thread with process id "pid", if it exists
+//======================================================================
+Thread *
+Thread::GetThread(int pid)
+{
+    if (pid < 0 || pid >= MaxProcessNum)
+        return NULL;
+    return threadTable[pid];
+}
+
 void
 Thread::Join(int pid)
 {
@@ -58,7 +58,10 @@
 
 #define MaxProcessNum 128
 
-#define MaxThreadPriority 3 //  0 = Highest Priority, 1 normal, 2 low
+#define MaxThreadPriority 64 // 0 = Highest Priority ... 63 = lowest
+#define HighThreadPriority 0
+#define NormalThreadPriority 32 // default
+#define LowThreadPriority (MaxThreadPriority - 1)
 
 // Thread state
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED };
@@ -105,23 +108,59 @@ class Thread {
     void CheckOverflow();   			// Check if thread has 
 						// overflowed its stack
     void setStatus(ThreadStatus st) { status = st; }
+    ThreadStatus getStatus() { return status; }
     char* getName() { return (name); }
     int getPid() { return pid; }
     // set priority before fork
     // changed priority will be effective immidiatly
     void setPriority(int prio) ;
-    int getPriority() { return priority; }
+    // the priority it is scheduled at: its own, or a better one
+    // inherited from a thread waiting for a lock it holds
+    int getPriority() { return min(priority, inheritedPriority); }
+    int getOwnPriority() { return priority; }
+    // the priority given by setPriority; the scheduler may move the
+    // thread away from it for a while (see Scheduler::SetMlfq)
+    int getBasePriority() { return basePriority; }
+    void adjustPriority(int prio);
+    void inheritPriority(int prio); // MaxThreadPriority: inherit none
 
     // count and manage thread running ticks
     int getTimerTick() { return timerTick; }
     void resetTimerTick() { timerTick = 0; }
     void increaseTimerTick() { timerTick ++; }
-    int  maxTimerTick() { return 1; }
+    int  maxTimerTick();	// timer interrupts in a time slice
 
     void Join(int pid);
+    static int NumThreads(); // threads that exist, in any state
+    static Thread *GetThread(int pid); // NULL if there is none
 
     int forkedPC; // recored when fork happen
 
+    Thread *readyNext; // links on the scheduler's ready list for
+    Thread *readyPrev; // this thread's priority, while READY
+
+    int vruntime;     // for the fair scheduler: weighted CPU time,
+    int fairTicket;   // entry in its tree of ready threads,
+    int runStart;     // and CPU ticks when last charged
+
+    // periodic real-time threads, scheduled earliest deadline first
+    bool SetPeriodic(int period, int budget, int deadline);
+                      // release a job every "period" ticks, needing
+                      // "budget" ticks of CPU by "deadline" ticks after
+                      // its release; FALSE if that cannot be guaranteed
+    void WaitForNextPeriod(); // this job is done, wait for the next
+    bool isPeriodic() { return period > 0; }
+
+    int period;       // 0 if not periodic
+    int budget;
+    int relativeDeadline;
+    int deadline;     // absolute deadline of the current job
+    int release;      // when the current job was released
+    int edfTicket;    // entry in the scheduler's tree of ready jobs
+
+    Lock *waitingFor; // the lock it is blocked in Acquire on, if any
+    Lock *locksHeld;  // the locks it holds, chained through the locks
+
     Condition *joinCondition; // broadcast when finish
     Lock *joinLock;
 
@@ -155,7 +194,10 @@ class Thread {
 
     int uid; // user id
     int pid; // process id
-    int priority; // priority , default 1 (normal)
+    int priority; // priority , default NormalThreadPriority
+    int basePriority; // priority set by setPriority
+    int inheritedPriority; // best priority of a thread waiting for
+                           // one of our locks (see Lock::Acquire)
     int timerTick; 
 
     int PidAllocate();
@@ -125,11 +125,11 @@ ThreadTest4()
     DEBUG('t', "Entering ThreadTest4");
 
     Thread *tLow = new Thread("forked thread low");
-    tLow->setPriority(2); // set priority before fork
+    tLow->setPriority(LowThreadPriority); // set priority before fork
     tLow->Fork(SimpleThread, 1);
 
     Thread *tHigh = new Thread("forked thread high");
-    tHigh->setPriority(0);
+    tHigh->setPriority(HighThreadPriority);
     tHigh->Fork(SimpleThread, 2);
 
     SimpleThread(0);
@@ -144,10 +144,10 @@ ThreadTest5()
 {
     DEBUG('t', "Entering ThreadTest5");    
     Thread *tHigh = new Thread("forked thread high");
-    tHigh->setPriority(0);
+    tHigh->setPriority(HighThreadPriority);
     tHigh->Fork(SimpleThreadLoop, 1);
     Thread *tNormal = new Thread("forked thread Normal");
-    tNormal->setPriority(1);
+    tNormal->setPriority(NormalThreadPriority);
     tNormal->Fork(SimpleThreadLoop, 2);
     SimpleThreadLoop(3);
     //printf("LEAVE!!!!\n");
@@ -405,6 +405,394 @@ ThreadTest9()
     currentThread -> Yield();
 }
 
+//=============================================================================
+// ThreadTest11
+// Test priority inheritance: "low" holds lock A; "mid" holds lock B and
+// waits for A; "high" waits for B.  Both should lend their priority
+// down the chain to "low", so that once it can go on, "low" and "mid"
+// get "high" its lock, and "high" finishes, before "hog" -- ready all
+// along, at a priority better than "low"'s or "mid"'s own -- runs.
+//=============================================================================
+
+Lock *lockA11, *lockB11;
+Semaphore *started11, *go11, *done11;
+char *order11[4];
+int finished11;
+
+void
+LowThread11(int which)
+{
+    lockA11->Acquire();
+    started11->V();
+    go11->P();                          // hold A until told to go on
+    lockA11->Release();
+    order11[finished11++] = "low";
+    done11->V();
+}
+
+void
+MidThread11(int which)
+{
+    lockB11->Acquire();
+    started11->V();
+    lockA11->Acquire();
+    lockA11->Release();
+    lockB11->Release();
+    order11[finished11++] = "mid";
+    done11->V();
+}
+
+void
+HighThread11(int which)
+{
+    started11->V();
+    lockB11->Acquire();
+    lockB11->Release();
+    order11[finished11++] = "high";
+    done11->V();
+}
+
+void
+HogThread11(int which)
+{
+    order11[finished11++] = "hog";
+    done11->V();
+}
+
+void
+ThreadTest11()
+{
+    DEBUG('t', "Entering ThreadTest11");
+    lockA11 = new Lock("lock A");
+    lockB11 = new Lock("lock B");
+    started11 = new Semaphore("started", 0);
+    go11 = new Semaphore("go", 0);
+    done11 = new Semaphore("done", 0);
+    finished11 = 0;
+    currentThread->setPriority(10);     // run ahead of all of them
+
+    Thread *low = new Thread("low");
+    low->setPriority(50);
+    low->Fork(LowThread11, 0);
+    started11->P();                     // low holds A
+    Thread *mid = new Thread("mid");
+    mid->setPriority(40);
+    mid->Fork(MidThread11, 0);
+    started11->P();                     // mid holds B, waits for A
+    printf("low runs at %d, mid at %d\n", low->getPriority(), 
+           mid->getPriority());
+    ASSERT(low->getPriority() == 40);
+
+    Thread *high = new Thread("high");
+    high->setPriority(20);
+    high->Fork(HighThread11, 0);
+    started11->P();                     // high waits for B
+    printf("low runs at %d, mid at %d\n", low->getPriority(), 
+           mid->getPriority());
+    ASSERT(low->getPriority() == 20 && mid->getPriority() == 20);
+
+    Thread *hog = new Thread("hog");
+    hog->setPriority(30);
+    hog->Fork(HogThread11, 0);
+    go11->V();
+    for (int i = 0; i < 4; ++i)
+    {
+        done11->P();
+    }
+    printf("finished in order: %s %s %s %s\n", order11[0], order11[1], 
+           order11[2], order11[3]);
+    ASSERT(strcmp(order11[0], "high") == 0 && strcmp(order11[1], "hog") == 0);
+    currentThread->setPriority(NormalThreadPriority);
+}
+
+//=============================================================================
+// ThreadTest12
+// Test an RWLock whose first reader finishes while another is still
+// reading, and a writer waits: the last reader out releases the lock
+// the finished thread acquired.
+//=============================================================================
+
+RWLock *rwlock12;
+Semaphore *done12;
+
+void
+Reader12(int which)
+{
+    rwlock12->ReadBegin();
+    printf("reader %d reading\n", which);
+    currentThread->Yield();             // let the others come in
+    if (which == 2)
+    {
+        currentThread->Yield();         // and reader 1 finish
+    }
+    rwlock12->ReadEnd();
+    printf("reader %d done\n", which);
+    done12->V();
+}
+
+void
+Writer12(int which)
+{
+    rwlock12->WriteBegin();             // waits for both readers
+    printf("writer writing\n");
+    rwlock12->WriteEnd();
+    done12->V();
+}
+
+void
+ThreadTest12()
+{
+    DEBUG('t', "Entering ThreadTest12");
+    rwlock12 = new RWLock("ThreadTest12");
+    done12 = new Semaphore("done", 0);
+
+    Thread *r1 = new Thread("reader 1");
+    r1->Fork(Reader12, 1);
+    Thread *r2 = new Thread("reader 2");
+    r2->Fork(Reader12, 2);
+    Thread *w = new Thread("writer");
+    w->Fork(Writer12, 0);
+    for (int i = 0; i < 3; ++i)
+    {
+        done12->P();
+    }
+    printf("readers and writer done\n");
+}
+
+//=============================================================================
+// ThreadTest13
+// Test earliest-deadline-first scheduling: "a" (a job every 1000 ticks,
+// due 400 ticks after its release) and "b" (every 500, due 500 after)
+// are admitted, but "c" would need more than the CPU they leave.  Jobs
+// run in deadline order; b's fourth job overruns, missing its
+// deadline, and its fifth is then already due -- but a's third is due
+// sooner, so it runs first.
+//=============================================================================
+
+struct Periodic13 {
+    char *name;
+    int jobs;                           // jobs to do before finishing
+    int work;                           // ticks (of 10) each job takes
+    int overrun;                        // the job that takes 60, or -1
+};
+
+Periodic13 a13 = { "a", 2, 10, -1 };
+Periodic13 b13 = { "b", 4, 5, 3 };
+char order13[16][4];
+int started13;
+Semaphore *done13;
+
+void
+PeriodicThread13(int arg)
+{
+    Periodic13 *p = (Periodic13 *) arg;
+
+    for (int job = 0; ; ++job)
+    {
+        sprintf(order13[started13++], "%s%d", p->name, job);
+        if (job == p->jobs)
+        {
+            break;                      // the last job is to finish
+        }
+        int work = (job == p->overrun) ? 60 : p->work;
+
+        for (int i = 0; i < work; ++i)
+        {
+            interrupt->OneTick();
+        }
+        currentThread->WaitForNextPeriod();
+    }
+    done13->V();
+}
+
+void
+ThreadTest13()
+{
+    DEBUG('t', "Entering ThreadTest13");
+    int jobs = stats->numRealTimeJobs;
+    int misses = stats->numDeadlineMisses;
+
+    done13 = new Semaphore("done", 0);
+    started13 = 0;
+    Thread *a = new Thread("a");
+    ASSERT(a->SetPeriodic(1000, 150, 400));     // 3/8 of the CPU
+    Thread *b = new Thread("b");
+    ASSERT(b->SetPeriodic(500, 150, 500));      // 3/10
+    Thread *c = new Thread("c");
+    ASSERT(!c->SetPeriodic(400, 200, 400));     // 1/2 is too much
+    ASSERT(!c->isPeriodic());
+
+    a->Fork(PeriodicThread13, (int) &a13);
+    b->Fork(PeriodicThread13, (int) &b13);
+    done13->P();
+    done13->P();
+
+    printf("jobs started:");
+    for (int i = 0; i < started13; ++i)
+    {
+        printf(" %s", order13[i]);
+    }
+    printf("\n%d jobs released, %d deadlines missed\n",
+           stats->numRealTimeJobs - jobs, stats->numDeadlineMisses - misses);
+    ASSERT(started13 == 8);
+    char *expected[] = { "a0", "b0", "b1", "a1", "b2", "b3", "a2", "b4" };
+    for (int i = 0; i < 8; ++i)
+    {
+        ASSERT(strcmp(order13[i], expected[i]) == 0);
+    }
+    ASSERT(stats->numRealTimeJobs - jobs == 8);
+    ASSERT(stats->numDeadlineMisses - misses == 1);
+}
+
+//=============================================================================
+// ThreadTest14
+// Test multilevel feedback (run with -mlfq, and without -rs, whose time
+// slices ignore priorities): "cpu" never gives up the CPU, so once it
+// has used a whole time slice it is demoted MlfqStep priorities, and
+// no later than MlfqAgingTime ticks after, aging puts it back at its
+// base priority.  "io" stands in for an I/O-bound thread: it waits, as
+// if for a device, after a little work, so it never uses up a time
+// slice and stays at its base priority.
+//=============================================================================
+
+bool cpuDone14;
+Semaphore *done14;
+
+void
+CpuThread14(int which)
+{
+    int base = currentThread->getBasePriority();
+
+    while (currentThread->getOwnPriority() == base)
+    {
+        interrupt->OneTick();
+    }
+    int demoted = stats->totalTicks;
+    printf("cpu demoted from %d to %d at tick %d\n", base, 
+           currentThread->getOwnPriority(), demoted);
+    ASSERT(currentThread->getOwnPriority() == base + MlfqStep);
+
+    while (currentThread->getOwnPriority() != base)
+    {
+        interrupt->OneTick();
+    }
+    printf("cpu back at %d at tick %d\n", base, stats->totalTicks);
+    ASSERT(stats->totalTicks - demoted <= MlfqAgingTime);
+    cpuDone14 = TRUE;
+    done14->V();
+}
+
+void
+IoThread14(int which)
+{
+    while (!cpuDone14)
+    {
+        interrupt->OneTick();
+        scheduler->IOWait(currentThread);
+        currentThread->Yield();         // as if waiting for a device
+    }
+    printf("io finished at %d\n", currentThread->getOwnPriority());
+    ASSERT(currentThread->getOwnPriority() == 
+           currentThread->getBasePriority());
+    done14->V();
+}
+
+void
+ThreadTest14()
+{
+    DEBUG('t', "Entering ThreadTest14");
+    if (!scheduler->IsMlfq())
+    {
+        printf("ThreadTest14 needs -mlfq\n");
+        return;
+    }
+    done14 = new Semaphore("done", 0);
+    cpuDone14 = FALSE;
+
+    Thread *cpu = new Thread("cpu");
+    cpu->Fork(CpuThread14, 0);
+    Thread *io = new Thread("io");
+    io->Fork(IoThread14, 0);
+    done14->P();
+    done14->P();
+}
+
+//=============================================================================
+// ThreadTest15
+// Test completely fair scheduling (run with -cfs, and without -rs, whose
+// time slices switch threads regardless): "high" and "low", 8
+// priorities apart, never give up the CPU, so "high" should get about
+// twice the CPU time.  Halfway through, "sleeper", blocked since it
+// started, is woken: it has had almost no CPU time, but starts only
+// FairSleeperCredit virtual ticks behind the others.
+//=============================================================================
+
+#define Work15 900                      // OneTicks for high and low
+int ran15[2];                           // OneTicks each has had
+int total15;
+Thread *sleeper15;
+Semaphore *wake15, *done15;
+
+void
+CpuThread15(int which)
+{
+    while (total15 < Work15)
+    {
+        interrupt->OneTick();
+        ran15[which]++;
+        if (++total15 == Work15 / 2)
+        {
+            int least = scheduler->MinVruntime();
+            printf("waking sleeper at virtual runtime %d, least is %d\n",
+                   sleeper15->vruntime, least);
+            ASSERT(sleeper15->vruntime < least - FairSleeperCredit);
+            wake15->V();
+            printf("sleeper starts at %d\n", sleeper15->vruntime);
+            ASSERT(sleeper15->vruntime == least - FairSleeperCredit);
+        }
+    }
+    done15->V();
+}
+
+void
+SleeperThread15(int which)
+{
+    wake15->P();
+    done15->V();
+}
+
+void
+ThreadTest15()
+{
+    DEBUG('t', "Entering ThreadTest15");
+    if (!scheduler->IsFair())
+    {
+        printf("ThreadTest15 needs -cfs\n");
+        return;
+    }
+    wake15 = new Semaphore("wake", 0);
+    done15 = new Semaphore("done", 0);
+    ran15[0] = ran15[1] = total15 = 0;
+
+    sleeper15 = new Thread("sleeper");
+    sleeper15->Fork(SleeperThread15, 0);
+    Thread *high = new Thread("high");
+    high->setPriority(NormalThreadPriority - 4);
+    high->Fork(CpuThread15, 0);
+    Thread *low = new Thread("low");
+    low->setPriority(NormalThreadPriority + 4);
+    low->Fork(CpuThread15, 1);
+    for (int i = 0; i < 3; ++i)
+    {
+        done15->P();
+    }
+
+    printf("high ran %d ticks, low %d\n", ran15[0] * SystemTick, 
+           ran15[1] * SystemTick);
+    ASSERT(2 * ran15[0] >= 3 * ran15[1]);      // between 3:2
+    ASSERT(2 * ran15[0] <= 5 * ran15[1]);      // and 5:2
+}
+
 #ifdef USER_PROGRAM
 #include "progtest.h"
 void userprogramTestSort(int which)
@@ -465,6 +853,21 @@ ThreadTest()
     case 9: // reader / writer problem via condition var
     ThreadTest9();
     break;
+    case 11: // priority inheritance
+    ThreadTest11();
+    break;
+    case 12: // RWLock handed on by a finished reader
+    ThreadTest12();
+    break;
+    case 13: // earliest deadline first
+    ThreadTest13();
+    break;
+    case 14: // multilevel feedback, with -mlfq
+    ThreadTest14();
+    break;
+    case 15: // completely fair scheduling, with -cfs
+    ThreadTest15();
+    break;
     case 10: // Run 2 User program!
     #ifdef USER_PROGRAM
     ThreadTest10();
@@ -15,6 +15,8 @@
 //   	'f' -- file system (FILESYS)
 //   	'a' -- address spaces (USER_PROGRAM)
 //   	'n' -- network emulation (NETWORK)
+//   	'p' -- performance counters read by user programs (USER_PROGRAM)
+//   	'k' -- kernel object (slab) caches
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
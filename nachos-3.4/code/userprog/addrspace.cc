@@ -253,5 +253,5 @@ void AddrSpace::RestoreState()
 {
     // machine->pageTable = pageTable;
     // Load TLB instead
-    pageManager->clearTLB();
+    pageManager->switchSpace();
 }
@@ -0,0 +1,148 @@
+// checkpoint.cc
+//	Routines to write and read back checkpoints of a user program.
+//	See checkpoint.h.
+
+#include "copyright.h"
+#include "system.h"
+#include "checkpoint.h"
+
+// The first thing in a checkpoint file, to check that it can be
+// restored into this run.
+
+class CheckpointHeader {
+  public:
+    int magic;			// CheckpointMagic
+    int geometry[4];		// PageSize, NumPhysPages, TLBSize, TLBWays
+    int numPages;		// size of the address space, and of 
+    int codeSize;		// its code, to recognize the program
+    int pid;			// of the thread running it
+    int priority;
+    bool finishInit;		// every page has been loaded once
+};
+
+static char *checkpointFile;	// where to write the checkpoint
+
+//----------------------------------------------------------------------
+// SetGeometry
+// 	Fill in the parts of a header that must match between the run
+//	writing a checkpoint and the one restoring it.
+//----------------------------------------------------------------------
+
+static void
+SetGeometry(CheckpointHeader *header, AddrSpace *space)
+{
+    header->magic = CheckpointMagic;
+    header->geometry[0] = PageSize;
+    header->geometry[1] = NumPhysPages;
+    header->geometry[2] = TLBSize;
+    header->geometry[3] = TLBWays;
+    header->numPages = space->numPages;
+    header->codeSize = space->noffH.code.size;
+}
+
+//----------------------------------------------------------------------
+// CheckpointHandler
+// 	Interrupt handler that writes the checkpoint.  The user registers
+//	are only consistent between two user instructions, so if the CPU
+//	was in the kernel, try again on the next tick.
+//----------------------------------------------------------------------
+
+static void
+CheckpointHandler(int dummy)
+{
+    CheckpointHeader header;
+    int fd;
+
+    if ((interrupt->getInterruptedStatus() != UserMode) ||
+		(currentThread->space == NULL)) {
+	interrupt->Schedule(CheckpointHandler, 0, 1, CheckpointInt);
+	return;
+    }
+    if (Thread::NumThreads() != 1) {
+	printf("Checkpoint: %d threads exist, only one can be saved\n",
+		Thread::NumThreads());
+	return;
+    }
+
+    SetGeometry(&header, currentThread->space);
+    header.pid = currentThread->getPid();
+    header.priority = currentThread->getPriority();
+    header.finishInit = currentThread->space->finishInit;
+
+    fd = OpenForWrite(checkpointFile);
+    WriteFile(fd, (char *) &header, sizeof(header));
+    WriteFile(fd, (char *) stats, sizeof(Statistics));
+    interrupt->Checkpoint(fd);
+    machine->Checkpoint(fd);
+    pageManager->Checkpoint(fd);
+    Close(fd);
+    printf("Checkpoint written to %s at tick %d\n", checkpointFile,
+		stats->totalTicks);
+}
+
+//----------------------------------------------------------------------
+// ScheduleCheckpoint
+// 	Arrange for a checkpoint to be written to the UNIX file 
+//	"fileName" at simulated time "when", or as soon after as the 
+//	program is between two instructions.
+//----------------------------------------------------------------------
+
+void
+ScheduleCheckpoint(char *fileName, int when)
+{
+    checkpointFile = fileName;
+    if (when <= stats->totalTicks)
+	when = stats->totalTicks + 1;
+    interrupt->Schedule(CheckpointHandler, 0, when - stats->totalTicks, 
+			CheckpointInt);
+}
+
+//----------------------------------------------------------------------
+// RestoreCheckpoint
+// 	Load the checkpoint in the UNIX file "fileName", so that the 
+//	current thread continues the program where it was saved.  Called
+//	instead of AddrSpace::InitRegisters, once "space" has been 
+//	created and made current, and before Machine::Run.
+//----------------------------------------------------------------------
+
+void
+RestoreCheckpoint(char *fileName, AddrSpace *space)
+{
+    CheckpointHeader header, expected;
+    Statistics saved;
+    int fd;
+
+    fd = OpenForReadWrite(fileName, TRUE);
+    Read(fd, (char *) &header, sizeof(header));
+    SetGeometry(&expected, space);
+    if ((header.magic != expected.magic) || 
+		(header.numPages != expected.numPages) || 
+		(header.codeSize != expected.codeSize)) {
+	printf("Restore: %s is not a checkpoint of this program\n", fileName);
+	Abort();
+    }
+    for (int i = 0; i < 4; i++)
+	if (header.geometry[i] != expected.geometry[i]) {
+	    printf("Restore: %s was taken with a different machine "
+		    "(-pages, -pagesize, -tlb, -tlbways)\n", fileName);
+	    Abort();
+	}
+
+    Read(fd, (char *) &saved, sizeof(Statistics));
+    interrupt->Restore(fd, saved.totalTicks);
+    *stats = saved;
+    machine->Restore(fd);
+    pageManager->Restore(fd, header.pid, currentThread->getPid());
+    Close(fd);
+
+    currentThread->setPriority(header.priority);
+    space->finishInit = header.finishInit;
+    if ((machine->tlb != NULL) && (header.pid != currentThread->getPid())) {
+	for (int i = 0; i < TLBSize; i++)	// entries are in the sets of
+	    machine->tlb[i].valid = FALSE;	// the old pid
+	if (machine->asid == header.pid)	// tagged with pids (-asid)
+	    machine->asid = currentThread->getPid();
+	machine->FlushHostTLB();
+    }
+    printf("Restored %s at tick %d\n", fileName, stats->totalTicks);
+}
@@ -0,0 +1,28 @@
+// checkpoint.h
+//	Save a running user program, with the simulated machine around it,
+//	to a UNIX file, and start a later run of Nachos from that point
+//	instead of from the beginning of the program.
+//
+//	A checkpoint holds the user registers, main memory and TLB, the
+//	inverted page table and swap area, the pending interrupts, the
+//	statistics, and the pid and priority of the thread.  It can only
+//	be taken while a single thread exists, running a user program:
+//	other threads are host stacks in the middle of kernel code, which
+//	cannot be written out.  The run that restores it must use the same
+//	program and the same -pages, -pagesize, -tlb and -tlbways options.
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "addrspace.h"
+
+#define CheckpointMagic	0x4e434b31	// "NCK1"
+
+extern void ScheduleCheckpoint(char *fileName, int when);
+				// Write a checkpoint once simulated time
+				// reaches "when"
+extern void RestoreCheckpoint(char *fileName, AddrSpace *space);
+				// Load one into the current thread, 
+				// which runs "space"
+
+#endif // CHECKPOINT_H
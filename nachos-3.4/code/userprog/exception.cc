@@ -82,6 +82,24 @@ void fork(int parentThread)
     PCChange(p->forkedPC);
 }
 
+//----------------------------------------------------------------------
+// ReadPerfCounter
+// 	The value of performance counter "which" (see syscall.h), or -1.
+//----------------------------------------------------------------------
+
+static int
+ReadPerfCounter(int which)
+{
+    switch (which) {
+      case PerfCycles:		return stats->totalTicks;
+      case PerfInstructions:	return stats->numUserInstructions;
+      case PerfTLBMisses:	return stats->numTLBMisses;
+      case PerfPageFaults:	return stats->numPageFaults;
+      case PerfDiskReads:	return stats->numDiskReads;
+      default:			return -1;
+    }
+}
+
 void
 ExceptionHandler(ExceptionType which)
 {
@@ -215,6 +233,19 @@ ExceptionHandler(ExceptionType which)
         currentThread->Yield();
         PCIncrease();
     }
+    else if ((which == SyscallException) && (type == SC_StartTiming))
+    {
+        machine->StartTiming();
+        PCIncrease();
+    }
+    else if ((which == SyscallException) && (type == SC_PerfCounter))
+    {
+        int counter = machine->ReadRegister(4);
+        int value = ReadPerfCounter(counter);
+        DEBUG('p', "PerfCounter %d = %d\n", counter, value);
+        machine->WriteRegister(2, value);
+        PCIncrease();
+    }
     else if ((which == SyscallException) && (type == SC_Join))
     {
         int pid = machine->ReadRegister(4);
@@ -13,6 +13,7 @@
 #include "console.h"
 #include "addrspace.h"
 #include "synch.h"
+#include "checkpoint.h"
 
 //----------------------------------------------------------------------
 // StartProcess
@@ -38,6 +39,8 @@ StartProcess(char *filename)
 
     space->InitRegisters();		// set the initial register values
     space->RestoreState();		// load page table register
+    if (restoreFile != NULL)		// continue from a checkpoint instead
+	RestoreCheckpoint(restoreFile, space);
 
     machine->Run();			// jump to the user progam
     ASSERT(FALSE);			// machine->Run never returns;
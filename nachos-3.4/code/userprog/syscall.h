@@ -29,6 +29,16 @@
 #define SC_Close	8
 #define SC_Fork		9
 #define SC_Yield	10
+#define SC_StartTiming	11
+#define SC_PerfCounter	12
+
+/* The performance counters PerfCounter can read */
+#define PerfCycles		0	/* simulated time, in ticks */
+#define PerfInstructions	1	/* user instructions completed */
+#define PerfTLBMisses		2	/* lookups that missed in the TLB */
+#define PerfPageFaults		3	/* pages brought into memory */
+#define PerfDiskReads		4	/* disk sectors read */
+#define NumPerfCounters		5
 
 #ifndef IN_ASM
 
@@ -124,6 +134,19 @@ void Fork(void (*func)());
  */
 void Yield();		
 
+/* End the fast-forward phase started by "nachos -ff 0": from here on,
+ * the simulation models the timing of everything in detail.  Does
+ * nothing if Nachos is not fast-forwarding.
+ */
+void StartTiming();
+
+/* Return the current value of performance counter "which" (one of the
+ * Perf... counters above), or -1 if there is no such counter.  The
+ * counters count for the whole machine, from when Nachos started, so
+ * to measure part of a program, subtract the values before and after.
+ */
+int PerfCounter(int which);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
@@ -4,18 +4,30 @@
 #include "machine.h"
 #include "invertedPage.h"
 #include "system.h"
+#include "profile.h"
+#include "trace.h"
 // ------------------------------- PUBLIC ---------------------------------------------
-PageManager::PageManager()
+PageManager::PageManager(bool tagTLB, bool walkTables)
 {
+	useASID = tagTLB;
+	useWalker = walkTables;
+	walkDirs = new TranslationEntry **[MaxProcessNum];
+	for (int i = 0; i < MaxProcessNum; ++i)
+		walkDirs[i] = NULL;
 	//Open swap file
 	//swapFile = NULL; // For file system DEBUG
 	swapFile = fileSystem->Open("swap5");
 
+	// sized from the machine geometry chosen at startup
+	invertedPageTable = new InvertedPageEntry[NumPhysPages];
+	swapPageTable = new InvertedPageEntry[SWAPPages];
 	for (int i = 0; i < NumPhysPages; ++i)
 	{
 		invertedPageTable[i].valid = FALSE;
 		invertedPageTable[i].hit = 0;
 	}
+	for (int i = 0; i < SWAPPages; ++i)
+		swapPageTable[i].valid = FALSE;
 }
 
 PageManager::~PageManager()
@@ -25,6 +37,11 @@ PageManager::~PageManager()
 		delete swapFile;
 		DEBUG('a', "### ~PageManager : SwapFile DELETE!");
 	}
+	delete [] invertedPageTable;
+	delete [] swapPageTable;
+	for (int i = 0; i < MaxProcessNum; ++i)
+		freeWalkTables(i);
+	delete [] walkDirs;
 }
 
 int PageManager::allocatePage(int virtAddr,bool isReadOnly)
@@ -43,6 +60,9 @@ int PageManager::allocatePage(int virtAddr,bool isReadOnly)
 
 void PageManager::deallocPage(int pid)
 {
+	if (useASID)
+		clearTLBOf(pid); // the pid may be reused
+	freeWalkTables(pid);
 	for (int i = 0; i < NumPhysPages; ++i)
 	{
 		if (invertedPageTable[i].pid == pid)
@@ -70,15 +90,19 @@ void PageManager::handlePageFault(int virtAddress)
 	int finded = findPage(ppnFrom,vpn,pid);
 	DEBUG('a', "### PageManager: page finded = %d ,for vpn = %d\n", 
                     finded, vpn);
-	stats->numPageFaults++;
 
 	if (finded >= 0) // PageFault case 1: in memory but not in TLB
 	{
 		// load page entry to tlb 
+		if (machine->profiler != NULL)
+			machine->profiler->CountTLBMiss(machine->ReadRegister(PCReg));
 		updateTLB(finded,vpn);	
 	} 
 	else 
 	{   // PageFault case 2: not in memory
+		stats->numPageFaults++; // a TLB miss is counted by the machine
+		if (machine->profiler != NULL)
+			machine->profiler->CountPageFault(machine->ReadRegister(PCReg));
 
 		finded = findPageInSwap(ppnFrom,vpn,pid); // find page in swap
 		
@@ -87,7 +111,7 @@ void PageManager::handlePageFault(int virtAddress)
 			// swap from disk !
 			DEBUG('a', "### PageManager: swap from disk, finded swapPPN = %d \n", 
                     finded);
-			swapUpPage(vpn,pid,finded);
+			finded = swapUpPage(vpn,pid,finded);
 		}
 		else
 		{
@@ -96,6 +120,7 @@ void PageManager::handlePageFault(int virtAddress)
 			DEBUG('a', "### PageManager: Init Space from file, vpn = %d, finded PPN = %d \n", 
                     vpn, finded);
 			bool readOnly = space->initSpace(vpn,finded);
+			machine->InvalidateDecodedPage(finded);
 			invertedPageTable[finded].virtualPage = vpn;
 			invertedPageTable[finded].pid = pid;
 			invertedPageTable[finded].use   = FALSE;
@@ -104,6 +129,8 @@ void PageManager::handlePageFault(int virtAddress)
 			invertedPageTable[finded].valid = TRUE;
 		}
 	}
+	if (useWalker) // from now on the hardware refills the TLB itself
+		setWalkEntry(pid, vpn, finded);
 
 	//printTable();
 }
@@ -115,6 +142,24 @@ void PageManager::handlePageFault(int virtAddress)
 		ASSERT(machine->tlb != NULL);
 		machine->tlb[i].valid = FALSE;
 	}
+	machine->FlushHostTLB();
+ }
+
+ void PageManager::switchSpace()
+ {
+	if (machine->tracer != NULL)
+		machine->tracer->SwitchSpace(getPID());
+	if (useWalker)
+		machine->pageDirectory = walkDirectory(getPID());
+	if (!useASID)
+	{
+		clearTLB();
+		return;
+	}
+	// entries of other processes stay, they just stop matching
+	DEBUG('a', "### PageManager::switchSpace to pid %d\n", getPID());
+	machine->asid = getPID();
+	machine->FlushHostTLB();
  }
 
  void PageManager::clonePages(int fromPid,int toPid)
@@ -124,29 +169,10 @@ void PageManager::handlePageFault(int virtAddress)
 
 // ------------------------------- PRIVATE ---------------------------------------------
 // 
-TranslationEntry * PageManager::tlbToBeReplace()
+// only the set that vpn maps to may hold it
+TranslationEntry * PageManager::tlbToBeReplace(int vpn)
 {
-	int minHit = 99999;
-	int oldest = 0;
-	for (int i = 0; i < TLBSize; ++i)
-	{
-		if (machine->tlb[i].valid == FALSE)
-		{
-			oldest = i;
-			break;
-		}
-		if (machine->tlb[i].hit < minHit)
-		{
-			minHit = machine->tlb[i].hit;
-			oldest = i;
-		}
-	}
-	for (int i = 0; i < TLBSize; ++i)
-	{
-		machine->tlb[i].hit = 0;
-	}
-	//printf("PageManager TLB to be Replace %d\n", oldest);
-	return &(machine->tlb[oldest]);
+	return machine->TLBVictim(vpn); // same policy as the hardware walker
 }
 
 void PageManager::updateTLB(int findedppn,int vpn)
@@ -154,8 +180,10 @@ void PageManager::updateTLB(int findedppn,int vpn)
 	DEBUG('a', "### PageManager::updateTLB,finded ppn = %d,\t vpn = %d \n", 
                     findedppn, vpn);
 	TranslationEntry *oldTLB; // tlb enrty to be replaced
-	oldTLB = tlbToBeReplace();
+	oldTLB = tlbToBeReplace(vpn);
+	machine->FlushHostTLB(); // oldTLB may be cached
 	oldTLB->valid = TRUE;
+	oldTLB->asid = machine->asid;
 	oldTLB->virtualPage= vpn;
 	oldTLB->physicalPage = findedppn;
 	oldTLB->use = 0;
@@ -284,7 +312,13 @@ int PageManager::swapDownPage()
 			DEBUG('a', "===============================PageManage swap Down Page ppn = %d vpn = %d to swapPageTable %d ... \n",
 				ppn,invertedPageTable[ppn].virtualPage,i);
 			invertedPageTable[ppn].valid = FALSE;
-			clearTLB();
+			if (useWalker)
+				clearWalkEntry(invertedPageTable[ppn].pid, invertedPageTable[ppn].virtualPage);
+			machine->InvalidateDecodedPage(ppn);
+			if (useASID)
+				clearTLBPage(ppn);
+			else
+				clearTLB();
 			return ppn;
 		}	
 	}
@@ -293,7 +327,7 @@ int PageManager::swapDownPage()
 	return -1;
 }
 
-void PageManager::swapUpPage(int vpn, int pid, int swapPage)
+int PageManager::swapUpPage(int vpn, int pid, int swapPage)
 {
 	int ppnFrom = hashVPN2PPN(vpn, pid);
 	int finded = findEmptyPage(ppnFrom); // find an empty page in memory
@@ -302,6 +336,7 @@ void PageManager::swapUpPage(int vpn, int pid, int swapPage)
 	int physicalAddr = finded * PageSize;
 	int inSwapAddr = swapPage * PageSize;
 	swapFile->ReadAt(&(machine->mainMemory[physicalAddr]),PageSize, inSwapAddr);
+	machine->InvalidateDecodedPage(finded);
 	swapPageTable[swapPage].valid = FALSE;
 	invertedPageTable[finded].readOnly = swapPageTable[swapPage].readOnly;
 	invertedPageTable[finded].virtualPage = vpn;
@@ -309,7 +344,7 @@ void PageManager::swapUpPage(int vpn, int pid, int swapPage)
 	invertedPageTable[finded].use = FALSE;
 	invertedPageTable[finded].dirty = FALSE;
 	invertedPageTable[finded].valid = TRUE;
-	return;
+	return finded;
 }
 
 void PageManager::updateHitFromTLB(){
@@ -318,14 +353,145 @@ void PageManager::updateHitFromTLB(){
 		if (machine->tlb[i].valid){
 			int ppn = machine->tlb[i].physicalPage;
 			int vpn =  machine->tlb[i].virtualPage;
-			if (invertedPageTable[ppn].valid && invertedPageTable[ppn].virtualPage == vpn)
+			if (invertedPageTable[ppn].valid && invertedPageTable[ppn].virtualPage == vpn &&
+				(!useASID || invertedPageTable[ppn].pid == machine->tlb[i].asid))
 			{
 				invertedPageTable[ppn].hit += machine->tlb[i].hit;
 			}
 		}
 	}
+	if (!useWalker)
+		return;
+	// TLB refills done by the hardware walker count as hits too
+	for (int i = 0; i < NumPhysPages; ++i)
+	{
+		TranslationEntry **dir = walkDirs[invertedPageTable[i].pid];
+		int vpn = invertedPageTable[i].virtualPage;
+		if (!invertedPageTable[i].valid || dir == NULL || dir[vpn / WalkTableSize] == NULL)
+			continue;
+		invertedPageTable[i].hit += dir[vpn / WalkTableSize][vpn % WalkTableSize].hit;
+		dir[vpn / WalkTableSize][vpn % WalkTableSize].hit = 0;
+	}
+}
+
+// Write the inverted page table, the swap table and the contents of
+// every page in the swap file to the open file fd.  Memory itself is
+// saved by Machine::Checkpoint.
+void PageManager::Checkpoint(int fd)
+{
+	char *page = new char[PageSize];
+	WriteFile(fd, (char *) invertedPageTable, NumPhysPages * sizeof(InvertedPageEntry));
+	WriteFile(fd, (char *) swapPageTable, SWAPPages * sizeof(InvertedPageEntry));
+	for (int i = 0; i < SWAPPages; ++i)
+	{
+		if (swapPageTable[i].valid)
+		{
+			swapFile->ReadAt(page, PageSize, i * PageSize);
+			WriteFile(fd, page, PageSize);
+		}
+	}
+	delete [] page;
 }
 
+// Read back what Checkpoint wrote.  The process may have a new pid in
+// this run: its pages are given to toPid.
+void PageManager::Restore(int fd, int fromPid, int toPid)
+{
+	char *page = new char[PageSize];
+	Read(fd, (char *) invertedPageTable, NumPhysPages * sizeof(InvertedPageEntry));
+	Read(fd, (char *) swapPageTable, SWAPPages * sizeof(InvertedPageEntry));
+	for (int i = 0; i < SWAPPages; ++i)
+	{
+		if (swapPageTable[i].valid)
+		{
+			Read(fd, page, PageSize);
+			swapFile->WriteAt(page, PageSize, i * PageSize);
+		}
+		if (swapPageTable[i].pid == fromPid)
+			swapPageTable[i].pid = toPid;
+	}
+	delete [] page;
+	for (int i = 0; i < NumPhysPages; ++i)
+	{
+		if (invertedPageTable[i].pid == fromPid)
+			invertedPageTable[i].pid = toPid;
+		if (useWalker && invertedPageTable[i].valid)
+			setWalkEntry(invertedPageTable[i].pid, invertedPageTable[i].virtualPage, i);
+	}
+}
+
+TranslationEntry ** PageManager::walkDirectory(int pid)
+{
+	if (walkDirs[pid] == NULL)
+	{
+		walkDirs[pid] = new TranslationEntry *[WalkDirSize];
+		for (int i = 0; i < WalkDirSize; ++i)
+			walkDirs[pid][i] = NULL;
+	}
+	return walkDirs[pid];
+}
+
+void PageManager::setWalkEntry(int pid, int vpn, int ppn)
+{
+	TranslationEntry **dir = walkDirectory(pid);
+	ASSERT(vpn / WalkTableSize < WalkDirSize);
+	if (dir[vpn / WalkTableSize] == NULL)
+	{
+		dir[vpn / WalkTableSize] = new TranslationEntry[WalkTableSize];
+		for (int i = 0; i < WalkTableSize; ++i)
+			dir[vpn / WalkTableSize][i].valid = FALSE;
+	}
+	TranslationEntry *pte = &dir[vpn / WalkTableSize][vpn % WalkTableSize];
+	pte->virtualPage = vpn;
+	pte->physicalPage = ppn;
+	pte->readOnly = invertedPageTable[ppn].readOnly;
+	pte->use = FALSE;
+	pte->dirty = FALSE;
+	pte->hit = 0;
+	pte->asid = pid;
+	pte->valid = TRUE;
+}
+
+void PageManager::clearWalkEntry(int pid, int vpn)
+{
+	TranslationEntry **dir = walkDirs[pid];
+	if (dir != NULL && dir[vpn / WalkTableSize] != NULL)
+		dir[vpn / WalkTableSize][vpn % WalkTableSize].valid = FALSE;
+}
+
+void PageManager::freeWalkTables(int pid)
+{
+	if (walkDirs[pid] == NULL)
+		return;
+	if (machine->pageDirectory == walkDirs[pid])
+		machine->pageDirectory = NULL;
+	for (int i = 0; i < WalkDirSize; ++i)
+		if (walkDirs[pid][i] != NULL)
+			delete [] walkDirs[pid][i];
+	delete [] walkDirs[pid];
+	walkDirs[pid] = NULL;
+}
+
+
+void PageManager::clearTLBOf(int pid)
+{
+	for (int i = 0; i < TLBSize; ++i)
+	{
+		if (machine->tlb[i].asid == pid)
+			machine->tlb[i].valid = FALSE;
+	}
+	machine->FlushHostTLB();
+}
+
+void PageManager::clearTLBPage(int ppn)
+{
+	for (int i = 0; i < TLBSize; ++i)
+	{
+		if (machine->tlb[i].physicalPage == ppn)
+			machine->tlb[i].valid = FALSE;
+	}
+	machine->FlushHostTLB();
+}
 
 int PageManager::hashVPN2PPN(unsigned int vpn,unsigned int pid) // hash based on visual addredd and thread id
 {
@@ -34,11 +34,13 @@ class InvertedPageEntry {
 class PageManager {
 public:
 
-    InvertedPageEntry invertedPageTable[NumPhysPages]; // inverted Page Table
+    InvertedPageEntry *invertedPageTable; // inverted Page Table, NumPhysPages entries
 
-    InvertedPageEntry swapPageTable[SWAPPages]; // Swap area often few times of Physical MEM; Now for test ! 
+    InvertedPageEntry *swapPageTable; // Swap area often few times of Physical MEM, SWAPPages entries
 
-    PageManager();
+    PageManager(bool tagTLB = FALSE, bool walkTables = FALSE);
+        // tagTLB: keep TLB entries of all processes, tagged by pid
+        // walkTables: keep page tables the hardware refills the TLB from
     ~PageManager();
 
     int allocatePage(int virtAddr,bool isReadOnly);
@@ -46,20 +48,34 @@ public:
     void handlePageFault(int virtAddress);
     void clonePages(int formPid,int toPid);
     void clearTLB();
+    void switchSpace(); // on context switch, make the TLB serve the current process
+
+    void Checkpoint(int fd); // save both tables and the swapped out pages
+    void Restore(int fd, int fromPid, int toPid); // pages of fromPid go to toPid
 
 private:
     OpenFile *swapFile;
+    bool useASID; // TLB entries are tagged with the pid (Machine::asid)
+
+    bool useWalker; // TLB misses are refilled by Machine::WalkPageTable
+    TranslationEntry ***walkDirs; // page directory of each pid, or NULL
+    TranslationEntry **walkDirectory(int pid); // created if needed
+    void setWalkEntry(int pid, int vpn, int ppn); // page now resident
+    void clearWalkEntry(int pid, int vpn); // page no longer resident
+    void freeWalkTables(int pid);
     int findEmptyPage(int from);
     int findPage(int from,int vpn,int pid);
     int findPageInSwap(int from,int vpn,int pid);
 
     int pageToBeSwapDown();
     int swapDownPage();
-    void swapUpPage(int vpn,int pid,int swapPage);
+    int swapUpPage(int vpn,int pid,int swapPage); // returns the ppn
 
     int hashVPN2PPN(unsigned int vpn,unsigned int pid);
 
-    TranslationEntry *tlbToBeReplace();
+    TranslationEntry *tlbToBeReplace(int vpn);
+    void clearTLBOf(int pid); // drop the TLB entries of one process
+    void clearTLBPage(int ppn); // drop the TLB entries mapping a physical page
     void updateTLB(int findedppn,int vpn); // findedppn != physicalPage
 
     void updateHitFromTLB();